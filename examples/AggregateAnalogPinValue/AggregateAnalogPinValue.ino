@@ -0,0 +1,57 @@
+/* AllThingsTalk Arduino WiFi SDK
+ * https://github.com/allthingstalk/arduino-wifi-sdk
+ *
+ * About this example: 
+ * Reads Analog pin A0 from your board as fast as it can, but only uploads the count, minimum, maximum,
+ * mean and variance of the readings to your AllThingsTalk Maker, once every 10 seconds.
+ * Value is uploaded using CBOR sending method.
+ * On startup it also prints how long adding a single reading to the aggregator takes on your board.
+ * This example will automatically create an asset "analog-stats-example" on your AllThingsTalk to which you'll receive the statistics
+ *
+ * Notes:
+ * - Create a device on your https://maker.allthingstalk.com (if you don't already have it)
+ *
+ * These are all the things in this example that you need to change to make it work:
+ *   WiFiSSID, WiFiPassword, DeviceID, DeviceToken
+ */
+
+#include <AllThingsTalk_WiFi.h>
+
+auto wifiCreds   = WifiCredentials("WiFiSSID", "WiFiPassword");   // Your WiFi Network Name and Password
+auto deviceCreds = DeviceConfig("DeviceID", "DeviceToken");       // Go to AllThingsTalk Maker > Devices > Your Device > Settings > Authentication to get your Device ID and Token
+auto device      = Device(wifiCreds, deviceCreds);                // Create "device" object
+CborPayload payload;                                              // Create CBOR payload object, so we can use CBOR sending
+SampleAggregator aggregator(10000);                               // Statistics over windows of 10 seconds
+int analog = aggregator.addAsset("analog-stats-example");         // Name of asset on AllThingsTalk to which you'll receive the statistics
+
+void measureUpdateCost() {
+  const long samples = 100000;
+  unsigned long start = micros();
+  for (long i = 0; i < samples; i++) {
+    aggregator.add(analog, i & 1023);
+  }
+  unsigned long elapsed = micros() - start;
+  Serial.print("Adding a reading takes ");
+  Serial.print(elapsed * 1000.0 / samples);
+  Serial.println(" ns");
+  aggregator.emit(payload, millis());  // Start over, so these readings don't get sent
+  payload.reset();
+}
+
+void setup() {
+  Serial.begin(115200);        // Baud rate: 115200, but you can define any baud rate you want   
+  device.debugPort(Serial);    // Set AllThingsTalk library to output its debug to "Serial"
+  device.createAsset("analog-stats-example", "Analog Statistics (SDK Example)", "sensor", "object"); // Create asset on AllThingsTalk to send statistics to
+  measureUpdateCost();         // Print how long a single reading takes to aggregate
+  device.init();               // Initialize WiFi and AllThingsTalk
+}
+
+void loop() {
+  device.loop();                               // Keep AllThingsTalk & WiFi Alive
+  aggregator.add(analog, analogRead(A0));      // Add a reading of the analog pin
+  if (aggregator.isComplete(millis())) {       // Every 10 seconds
+    payload.reset();                           // Reset the payload
+    aggregator.emit(payload, millis());        // Set the statistics of the last 10 seconds
+    device.send(payload);                      // Send the payload
+  }
+}
@@ -16,13 +16,14 @@
  */
 
 #include <AllThingsTalk_WiFi.h>
+#include <PayloadPool.h>
 
 auto wifiCreds   = WifiCredentials("WiFiSSID", "WiFiPassword");   // Your WiFi Network Name and Password
 auto deviceCreds = DeviceConfig("DeviceID", "DeviceToken");       // Go to AllThingsTalk Maker > Devices > Your Device > Settings > Authentication to get your Device ID and Token
 auto device      = Device(wifiCreds, deviceCreds);                // Create "device" object
 char* actuator   = "relay-msg-actuator-example";                  // Name of asset on AllThingsTalk that you'll use to send a message (automatically created below)
 char* sensor     = "relay-msg-sensor-example";                    // Name of asset on AllThingsTalk that you'll receive a message on (automatically created below)
-CborPayload payload;                                              // Create CBOR payload object, so we can use CBOR to send data
+PayloadPool<CborPayload, 2, 256> pool;                            // 2 CBOR payloads of 256 bytes, created once and lent out per message
 
 void setup() {
   Serial.begin(115200);                   // Baud rate: 115200, but you can define any baud rate you want
@@ -40,7 +41,11 @@ void loop() {
 void actuation(String value) {            // Function called when message arrives on asset "actuator" defined above
   Serial.print("Received message: ");     // Prints to serial output
   Serial.println(value);                  // Prints actual value received to serial output
-  payload.reset();                        // Resets the payload
-  payload.set(sensor, value);             // Adds "value" received to be sent to sensor asset (defined above) on AllThingsTalk Maker
-  device.send(payload);                   // Sends the set payload(s)
-}
\ No newline at end of file
+  auto payload = pool.acquire();          // Borrows an empty payload from the pool
+  if (!payload) {                         // False if every payload in the pool is in use
+    Serial.println("No payload free to relay the message");
+    return;
+  }
+  payload->set(sensor, value);            // Adds "value" received to be sent to sensor asset (defined above) on AllThingsTalk Maker
+  device.send(*payload);                  // Sends the set payload(s)
+}                                         // The payload goes back to the pool here
\ No newline at end of file
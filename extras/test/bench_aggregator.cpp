@@ -0,0 +1,40 @@
+// Cost of aggregating one reading, and of emitting a window. The
+// AggregateAnalogPinValue example measures add() the same way on a board.
+#include "test.h"
+#include "SampleAggregator.h"
+
+int main() {
+    const unsigned long samples = 50000000;
+
+    SampleAggregator tumbling(1000);
+    int asset = tumbling.addAsset("vibration");
+    double tumblingNs = nanosecondsPer(samples, [&](unsigned long i) {
+        tumbling.add(asset, (float)(i & 1023));
+    });
+    keep(tumbling.getStats(asset).mean);
+
+    SampleAggregator sliding(1000, 4, 10);
+    int assets[4];
+    for (int i = 0; i < 4; i++) {
+        assets[i] = sliding.addAsset("a");
+    }
+    double slidingNs = nanosecondsPer(samples, [&](unsigned long i) {
+        sliding.add(assets[i & 3], (float)(i & 1023));
+    });
+
+    keep(sliding.getStats(assets[0]).mean);
+
+    CborPayload payload(256);
+    unsigned long now = 0;
+    double emitNs = nanosecondsPer(200000, [&](unsigned long i) {
+        payload.reset();
+        sliding.add(assets[i & 3], (float)i);
+        now += 100;
+        keep(sliding.emit(payload, now));
+    });
+
+    printf("add, 1 asset, tumbling:   %.2f ns/reading\n", tumblingNs);
+    printf("add, 4 assets, 10 slices: %.2f ns/reading\n", slidingNs);
+    printf("emit, 4 assets, 10 slices: %.0f ns/window\n", emitNs);
+    return 0;
+}
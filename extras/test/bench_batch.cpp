@@ -0,0 +1,54 @@
+// Decoding CborPayload messages from many devices into a CborBatch, in
+// messages per second on one core
+#include "test.h"
+#include "CborBatch.h"
+#include "CborPayload.h"
+
+#include <vector>
+
+int main() {
+    const unsigned int messageCount = 4096;
+    const unsigned long rounds = 200;
+
+    // Every message has a timestamp, a location and five assets
+    std::vector<std::vector<unsigned char> > encoded;
+    for (unsigned int i = 0; i < messageCount; i++) {
+        CborPayload payload;
+        payload.set((char *)"temperature", 20.0f + i % 50 / 10.0f);
+        payload.set((char *)"humidity", (int)(40 + i % 30));
+        payload.set((char *)"door", i % 2 == 0);
+        payload.set((char *)"status", (char *)"ok");
+        payload.set((char *)"battery-level", 3.7 - i % 100 / 1000.0);
+        payload.setTimestamp(1700000000ULL + i);
+        payload.setLocation(GeoLocation(51.0f + i % 10 / 100.0f, 3.7f));
+        encoded.push_back(std::vector<unsigned char>(payload.getBytes(), payload.getBytes() + payload.getSize()));
+    }
+    std::vector<const unsigned char *> messages;
+    std::vector<unsigned int> lengths;
+    unsigned long bytes = 0;
+    for (unsigned int i = 0; i < messageCount; i++) {
+        messages.push_back(&encoded[i][0]);
+        lengths.push_back(encoded[i].size());
+        bytes += encoded[i].size();
+    }
+
+    CborBatchDecoder decoder;
+    CborBatch batch(1024);
+    unsigned long rows = 0;
+    double ns = nanosecondsPer(rounds, [&](unsigned long) {
+        unsigned int done = 0;
+        while (done < messageCount) {
+            batch.clear();
+            done += decoder.decode(&messages[done], &lengths[done], messageCount - done, batch);
+            rows += batch.size;
+        }
+        keep(batch);
+    });
+
+    double perMessage = ns / messageCount;
+    printf("%u messages of %lu bytes on average, %lu rows per round\n",
+        messageCount, bytes / messageCount, rows / rounds);
+    printf("%.1f ns/message, %.2f million messages/s per core, %.0f MB/s\n",
+        perMessage, 1000.0 / perMessage, bytes / (ns / 1000.0));
+    return 0;
+}
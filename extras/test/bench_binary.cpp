@@ -0,0 +1,61 @@
+// Packing 256 int16 samples: add() per value, addArray(), and the byte by
+// byte reversal with a runtime byte order flag that add() used before
+#include "test.h"
+#include "BinaryPayload.h"
+
+static bool runtimeLittleEndian() {
+    const uint16_t probe = 1;
+    return *(const unsigned char *)&probe == 1;
+}
+
+// Out of line, like add() was and is
+template<typename T> __attribute__((noinline)) static unsigned int addByteByByte(unsigned char *buffer, unsigned int offset,
+        unsigned int capacity, bool littleEndian, T t) {
+    if (sizeof(t) + offset > capacity) return offset;
+    unsigned char *arr = (unsigned char *)&t;
+    for (unsigned int i = 0; i < sizeof(T); i++) {
+        buffer[offset++] = arr[littleEndian ? sizeof(T) - 1 - i : i];
+    }
+    return offset;
+}
+
+int main() {
+    const int samples = 256;
+    const unsigned long rounds = 200000;
+    int16_t values[samples];
+    for (int i = 0; i < samples; i++) {
+        values[i] = (int16_t)(i * 37 - 4000);
+    }
+
+    static unsigned char buffer[1024];
+    bool littleEndian = runtimeLittleEndian();
+    double byteNs = nanosecondsPer(rounds, [&](unsigned long) {
+        unsigned int offset = 0;
+        for (int i = 0; i < samples; i++) {
+            offset = addByteByByte(buffer, offset, sizeof buffer, littleEndian, values[i]);
+        }
+        keep(buffer);
+    });
+
+    BinaryPayload single(1024);
+    double addNs = nanosecondsPer(rounds, [&](unsigned long) {
+        single.reset();
+        for (int i = 0; i < samples; i++) {
+            single.add(values[i]);
+        }
+        keep(single);
+    });
+
+    BinaryPayload array(1024);
+    double arrayNs = nanosecondsPer(rounds, [&](unsigned long) {
+        array.reset();
+        array.addArray(values, samples);
+        keep(array);
+    });
+
+    printf("256 int16 samples\n");
+    printf("byte by byte, runtime flag: %7.1f ns\n", byteNs);
+    printf("add() per sample:           %7.1f ns\n", addNs);
+    printf("addArray():                 %7.1f ns\n", arrayNs);
+    return 0;
+}
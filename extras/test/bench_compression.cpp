@@ -0,0 +1,50 @@
+// Compression of a large diagnostic CborPayload and of a CborSeriesPayload,
+// and decompression of both
+#include "test.h"
+#include "CborPayload.h"
+#include "CborSeriesPayload.h"
+#include "PayloadCompression.h"
+
+#include <stdlib.h>
+
+static void measure(const char *name, const unsigned char *data, unsigned int size) {
+    const unsigned long rounds = 2000;
+    unsigned char *compressed = new unsigned char[size];
+    unsigned char *restored = new unsigned char[size];
+
+    unsigned int compressedSize = 0;
+    double compressNs = nanosecondsPer(rounds, [&](unsigned long) {
+        compressedSize = compressPayload(data, size, compressed, size);
+        keep(compressedSize);
+    });
+    int restoredSize = 0;
+    double decompressNs = nanosecondsPer(rounds, [&](unsigned long) {
+        restoredSize = decompressPayload(compressed, compressedSize, restored, size);
+        keep(restoredSize);
+    });
+    CHECK(compressedSize > 0 && restoredSize == (int)size);
+    CHECK_BYTES(data, restored, size);
+
+    printf("%s: %u -> %u bytes, compress %.2f ns/byte, decompress %.2f ns/byte\n",
+        name, size, compressedSize, compressNs / size, decompressNs / size);
+    delete[] compressed;
+    delete[] restored;
+}
+
+int main() {
+    static char names[40][24];
+    CborPayload diagnostics(2048);
+    srand(1);
+    for (int i = 0; i < 40; i++) {
+        snprintf(names[i], sizeof names[i], "diagnostic-counter-%02d", i);
+        diagnostics.set(names[i], (float)(rand() % 1000) / 10);
+    }
+    measure("40-asset CborPayload", diagnostics.getBytes(), diagnostics.getSize());
+
+    CborSeriesPayload series(4096, 300, 1);
+    for (int i = 0; i < 300; i++) {
+        series.add("temperature", 1700000000000ULL + i * 1000, 21.5f + (float)(rand() % 5) / 10);
+    }
+    measure("300-sample CborSeriesPayload", series.getBytes(), series.getSize());
+    return testResult();
+}
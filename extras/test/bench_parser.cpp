@@ -0,0 +1,66 @@
+// Decoding a map of 30 string keys to integers, with the pull parser and
+// with CborReader's listener callbacks
+#include "test.h"
+#include "CborDecoder.h"
+#include "CborEncoder.h"
+
+#include <stdio.h>
+
+class SumListener : public CborListener {
+public:
+    int64_t sum = 0;
+    unsigned int keyBytes = 0;
+
+    virtual void OnInteger(int32_t value) { sum += value; }
+    virtual void OnBytes(unsigned char *data, unsigned int size) { delete[] data; }
+    virtual void OnString(String &str) { keyBytes += str.length(); }
+    virtual void OnArray(unsigned int size) {}
+    virtual void OnMap(unsigned int size) {}
+    virtual void OnTag(uint32_t tag) {}
+    virtual void OnSpecial(uint32_t code) {}
+    virtual void OnError(const char *error) { printf("error: %s\n", error); }
+};
+
+int main() {
+    const unsigned long rounds = 200000;
+    unsigned char message[1024];
+    CborStaticOutput output(message, sizeof message);
+    CborWriter writer(output);
+    writer.writeMap(30);
+    for (int i = 0; i < 30; i++) {
+        char key[32];
+        int length = snprintf(key, sizeof key, "sensor-asset-%02d", i);
+        writer.writeString(key, length);
+        writer.writeInt((int32_t)(i * 1000));
+    }
+    unsigned int size = output.getSize();
+
+    double parserNs = nanosecondsPer(rounds, [&](unsigned long) {
+        CborInput input(message, size);
+        CborParser parser(input);
+        int64_t sum = 0;
+        unsigned int keyBytes = 0;
+        while (parser.next()) {
+            if (parser.type() == CBOR_TYPE_STRING) {
+                keyBytes += parser.asStringView().length;
+            } else if (parser.type() == CBOR_TYPE_INTEGER) {
+                sum += parser.asInt();
+            }
+        }
+        keep(sum);
+        keep(keyBytes);
+    });
+
+    SumListener listener;
+    double listenerNs = nanosecondsPer(rounds, [&](unsigned long) {
+        CborInput input(message, size);
+        CborReader reader(input, listener);
+        reader.Run();
+        keep(listener.sum);
+    });
+
+    printf("%u byte message, 30 string keys\n", size);
+    printf("CborParser:   %8.1f ns/message\n", parserNs);
+    printf("CborListener: %8.1f ns/message\n", listenerNs);
+    return 0;
+}
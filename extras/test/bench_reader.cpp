@@ -0,0 +1,73 @@
+// CborReader decode throughput on CborPayload messages: Run() over the
+// whole message, and the validating mode fed whole and in 64 byte chunks
+#include "test.h"
+#include "CborDecoder.h"
+#include "CborPayload.h"
+
+class CountingListener : public CborListener {
+public:
+    bool limited = false;
+    unsigned long items = 0;
+
+    virtual void OnInteger(int32_t value) { items++; }
+    virtual void OnBytes(unsigned char *data, unsigned int size) {
+        items++;
+        if (!limited) delete[] data;
+    }
+    virtual void OnString(String &str) { items++; }
+    virtual void OnStringData(const char *data, unsigned int size) { items++; }
+    virtual void OnArray(unsigned int size) { items++; }
+    virtual void OnMap(unsigned int size) { items++; }
+    virtual void OnTag(uint32_t tag) { items++; }
+    virtual void OnSpecial(uint32_t code) { items++; }
+    virtual void OnError(const char *error) { printf("error: %s\n", error); }
+    virtual void OnFloat(double value) { items++; }
+};
+
+int main() {
+    const unsigned long rounds = 200000;
+    CborPayload payload(512);
+    payload.set((char *)"temperature", 21.5f);
+    payload.set((char *)"humidity", 40);
+    payload.set((char *)"door", true);
+    payload.set((char *)"status", (char *)"running normally");
+    payload.set((char *)"battery-level", 3.71);
+    CborBuilder window = payload.setArray((char *)"window", 8);
+    for (int i = 0; i < 8; i++) window.add(1000 + i);
+    window.end();
+    payload.setTimestamp(1700000000ULL);
+    payload.setLocation(GeoLocation(51.0f, 3.7f));
+    unsigned char *message = payload.getBytes();
+    unsigned int size = payload.getSize();
+
+    CountingListener listener;
+    double runNs = nanosecondsPer(rounds, [&](unsigned long) {
+        CborInput input(message, size);
+        CborReader reader(input, listener);
+        reader.Run();
+    });
+
+    static unsigned char scratch[256];
+    CountingListener limitedListener;
+    limitedListener.limited = true;
+    CborReader limited(limitedListener);
+    limited.SetLimits(64, 4, 64, scratch, sizeof scratch);
+    double limitedNs = nanosecondsPer(rounds, [&](unsigned long) {
+        limited.Reset();
+        limited.Feed(message, size);
+    });
+    double chunkedNs = nanosecondsPer(rounds, [&](unsigned long) {
+        limited.Reset();
+        for (unsigned int offset = 0; offset < size; offset += 64) {
+            limited.Feed(message + offset, size - offset < 64 ? size - offset : 64);
+        }
+    });
+    keep(listener.items);
+    keep(limitedListener.items);
+
+    printf("%u byte message, %lu items\n", size, listener.items / rounds);
+    printf("Run():                 %6.1f ns/message, %5.1f MB/s\n", runNs, size * 1000.0 / runNs);
+    printf("SetLimits(), whole:    %6.1f ns/message, %5.1f MB/s\n", limitedNs, size * 1000.0 / limitedNs);
+    printf("SetLimits(), 64 bytes: %6.1f ns/message, %5.1f MB/s\n", chunkedNs, size * 1000.0 / chunkedNs);
+    return 0;
+}
@@ -0,0 +1,35 @@
+// 256 int16_t samples as a CBOR array of integers and as one typed array
+#include "test.h"
+#include "CborEncoder.h"
+
+int main() {
+    const unsigned int samples = 256;
+    const unsigned long rounds = 200000;
+    int16_t data[samples];
+    for (unsigned int i = 0; i < samples; i++) {
+        data[i] = (int16_t)(i * 97 - 12000);
+    }
+
+    CborStaticOutput itemsOutput(2048);
+    CborWriter items(itemsOutput);
+    double itemsNs = nanosecondsPer(rounds, [&](unsigned long) {
+        itemsOutput.reset();
+        items.writeArray(samples);
+        for (unsigned int i = 0; i < samples; i++) {
+            items.writeInt((int32_t)data[i]);
+        }
+        keep(itemsOutput);
+    });
+
+    CborStaticOutput typedOutput(2048);
+    CborWriter typed(typedOutput);
+    double typedNs = nanosecondsPer(rounds, [&](unsigned long) {
+        typedOutput.reset();
+        typed.writeTypedArray(data, samples);
+        keep(typedOutput);
+    });
+
+    printf("array of integers: %4u bytes, %7.1f ns\n", itemsOutput.getSize(), itemsNs);
+    printf("typed array:       %4u bytes, %7.1f ns\n", typedOutput.getSize(), typedNs);
+    return 0;
+}
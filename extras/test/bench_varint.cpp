@@ -0,0 +1,42 @@
+// Counter increments and small temperature deltas, as fixed size integers
+// and as varint/zigzag
+#include "test.h"
+#include "BinaryPayload.h"
+
+#include <stdlib.h>
+
+int main() {
+    const int samples = 256;
+    const unsigned long rounds = 20000;
+    int32_t increments[samples];
+    int32_t deltas[samples];
+    srand(1);
+    for (int i = 0; i < samples; i++) {
+        increments[i] = 3;
+        deltas[i] = rand() % 41 - 20;
+    }
+
+    BinaryPayload fixed(4096);
+    double fixedNs = nanosecondsPer(rounds, [&](unsigned long) {
+        fixed.reset();
+        for (int i = 0; i < samples; i++) {
+            fixed.add(increments[i]);
+            fixed.add(deltas[i]);
+        }
+        keep(fixed);
+    });
+
+    BinaryPayload varint(4096);
+    double varintNs = nanosecondsPer(rounds, [&](unsigned long) {
+        varint.reset();
+        for (int i = 0; i < samples; i++) {
+            varint.addVarint(increments[i]);
+            varint.addZigzag(deltas[i]);
+        }
+        keep(varint);
+    });
+
+    printf("fixed:  %4u bytes, %.2f ns/value\n", fixed.getSize(), fixedNs / samples / 2);
+    printf("varint: %4u bytes, %.2f ns/value\n", varint.getSize(), varintNs / samples / 2);
+    return 0;
+}
@@ -0,0 +1,171 @@
+// Fuzz harness for CborReader: random bytes and mutated CborPayload
+// messages, fed whole and in random pieces, with and without SetLimits().
+// Run it under -DSDK_SANITIZE=ON to catch memory errors; it checks the
+// limits itself. The first argument sets the number of rounds.
+#include "test.h"
+#include "CborDecoder.h"
+#include "CborPayload.h"
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+static const unsigned int maxStringLength = 64;
+static const unsigned int maxDepth = 4;
+static const unsigned long maxItems = 48;
+
+class CheckingListener : public CborListener {
+public:
+    bool limited = false;
+    const unsigned char *scratch = NULL;
+    unsigned int scratchSize = 0;
+    unsigned long items = 0;
+    unsigned int violations = 0;
+    std::string log;
+
+    void item(const char *kind, uint64_t value) {
+        items++;
+        log += kind;
+        log += std::to_string(value);
+        log += ',';
+    }
+    void string(const unsigned char *data, unsigned int size) {
+        if (limited && (size > maxStringLength || data < scratch || data + size > scratch + scratchSize)) {
+            violations++;
+        }
+    }
+
+    virtual void OnInteger(int32_t value) { item("i", (uint32_t)value); }
+    virtual void OnBytes(unsigned char *data, unsigned int size) {
+        string(data, size);
+        item("b", size);
+        if (!limited) delete[] data;
+    }
+    virtual void OnString(String &str) { item("s", str.length()); }
+    virtual void OnStringData(const char *data, unsigned int size) {
+        string((const unsigned char *)data, size);
+        item("s", size);
+    }
+    virtual void OnArray(unsigned int size) {
+        if (limited && size > maxItems) violations++;
+        item("a", size);
+    }
+    virtual void OnMap(unsigned int size) {
+        if (limited && 2UL * size > maxItems) violations++;
+        item("m", size);
+    }
+    virtual void OnTag(uint32_t tag) { item("t", tag); }
+    virtual void OnSpecial(uint32_t code) { item("x", code); }
+    virtual void OnError(const char *error) { log += "error,"; }
+    virtual void OnFloat(double value) { item("f", 0); }
+    virtual void OnExtraInteger(uint64_t value, int sign) { item("e", value); }
+    virtual void OnExtraTag(uint64_t tag) { item("T", tag); }
+};
+
+static std::vector<std::vector<unsigned char> > seeds() {
+    std::vector<std::vector<unsigned char> > messages;
+    for (int i = 0; i < 8; i++) {
+        CborPayload payload(512);
+        payload.set((char *)"temperature", 21.5f + i);
+        payload.set((char *)"count", 100000 * i);
+        payload.set((char *)"status", (char *)"a somewhat longer status text for the seeds");
+        const unsigned char blob[] = {1, 2, 3, 4, 5, 6};
+        payload.setBytes((char *)"blob", blob, sizeof blob);
+        CborBuilder nested = payload.setObject((char *)"nested", 2);
+        nested.add(1);
+        CborBuilder inner = nested.setArray((char *)"list", 3);
+        inner.add(1.5);
+        inner.add(true);
+        inner.add((char *)"x");
+        nested.end();
+        if (i % 2) payload.setTimestamp(1700000000ULL + i);
+        if (i % 4 == 1) payload.setLocation(GeoLocation(51.0f, 3.7f, 12.0f));
+        messages.push_back(std::vector<unsigned char>(payload.getBytes(), payload.getBytes() + payload.getSize()));
+    }
+    return messages;
+}
+
+// Flips, inserts, removes or overwrites bytes with interesting headers
+static void mutate(std::vector<unsigned char> &message) {
+    static const unsigned char headers[] = {0x1B, 0x3B, 0x5A, 0x7A, 0x9A, 0xBA, 0xDA, 0xFB, 0x9F, 0xFF, 0x7F, 0x1F};
+    int mutations = 1 + rand() % 4;
+    for (int i = 0; i < mutations; i++) {
+        unsigned int at = message.empty() ? 0 : rand() % message.size();
+        switch (rand() % 5) {
+            case 0:
+                if (!message.empty()) message[at] ^= 1 << (rand() % 8);
+                break;
+            case 1:
+                message.insert(message.begin() + at, rand() & 0xFF);
+                break;
+            case 2:
+                if (!message.empty()) message.erase(message.begin() + at);
+                break;
+            case 3:
+                if (!message.empty()) message[at] = headers[rand() % sizeof headers];
+                break;
+            default:
+                if (!message.empty()) message[at] = 0xFF;
+                break;
+        }
+    }
+}
+
+static std::string feed(CborReader &reader, CheckingListener &listener, const std::vector<unsigned char> &message,
+        bool split) {
+    listener.log.clear();
+    listener.items = 0;
+    reader.Reset();
+    unsigned int offset = 0;
+    while (offset < message.size()) {
+        unsigned int size = split ? 1 + rand() % 16 : message.size();
+        if (size > message.size() - offset) size = message.size() - offset;
+        reader.Feed(&message[offset], size);
+        offset += size;
+    }
+    return listener.log;
+}
+
+int main(int argc, char **argv) {
+    unsigned long rounds = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    std::vector<std::vector<unsigned char> > seedMessages = seeds();
+    static unsigned char scratch[maxDepth * sizeof(uint32_t) + maxStringLength + 8];
+    srand(37);
+
+    unsigned int mismatches = 0;
+    unsigned long tooMany = 0;
+    for (unsigned long round = 0; round < rounds; round++) {
+        std::vector<unsigned char> message;
+        if (round % 4 == 0) {
+            message.resize(rand() % 64);
+            for (unsigned int i = 0; i < message.size(); i++) message[i] = rand() & 0xFF;
+        } else {
+            message = seedMessages[rand() % seedMessages.size()];
+            mutate(message);
+        }
+        if (message.empty()) continue;
+
+        for (int limited = 0; limited < 2; limited++) {
+            CheckingListener listener;
+            CborReader reader(listener);
+            if (limited) {
+                CHECK(reader.SetLimits(maxStringLength, maxDepth, maxItems, scratch, sizeof scratch));
+                listener.limited = true;
+                listener.scratch = scratch;
+                listener.scratchSize = sizeof scratch;
+            }
+            std::string whole = feed(reader, listener, message, false);
+            if (limited && listener.items > maxItems) tooMany++;
+            std::string pieces = feed(reader, listener, message, true);
+            if (whole != pieces && mismatches++ < 3) {
+                printf("round %lu, %s: split feed differs\n%s\n%s\n", round, limited ? "limited" : "unlimited",
+                    whole.c_str(), pieces.c_str());
+            }
+            CHECK(listener.violations == 0);
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(tooMany == 0);
+    printf("%lu rounds\n", rounds);
+    return testResult();
+}
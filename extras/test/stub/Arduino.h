@@ -0,0 +1,112 @@
+// The parts of the Arduino core the SDK's payload and CBOR code uses, so
+// that code can be built and tested on a host. Not a general replacement.
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+
+class String {
+public:
+    String() {}
+    String(const char *text) : text(text ? text : "") {}
+    String(const std::string &text) : text(text) {}
+    String(int value, unsigned char base = DEC) : text(format(base == HEX ? "%x" : "%d", value)) {}
+    String(unsigned int value, unsigned char base = DEC) : text(format(base == HEX ? "%x" : "%u", value)) {}
+    String(long value, unsigned char base = DEC) : text(format(base == HEX ? "%lx" : "%ld", value)) {}
+    String(unsigned long value, unsigned char base = DEC) : text(format(base == HEX ? "%lx" : "%lu", value)) {}
+    String(double value, unsigned int decimals = 2) : text(format("%.*f", (int)decimals, value)) {}
+
+    unsigned int length() const { return text.size(); }
+    const char *c_str() const { return text.c_str(); }
+    bool reserve(unsigned int size) { text.reserve(size); return true; }
+    void toCharArray(char *buffer, unsigned int size) const {
+        if (size == 0) return;
+        strncpy(buffer, text.c_str(), size);
+        buffer[size - 1] = 0;
+    }
+    char operator[](unsigned int index) const { return text[index]; }
+    String substring(unsigned int from) const { return String(text.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const { return String(text.substr(from, to - from)); }
+    bool equals(const String &other) const { return text == other.text; }
+    bool operator==(const String &other) const { return text == other.text; }
+    bool operator==(const char *other) const { return text == other; }
+    String &operator+=(const String &other) { text += other.text; return *this; }
+    String &operator+=(const char *other) { text += other; return *this; }
+    String &operator+=(char other) { text += other; return *this; }
+    String &operator+=(int other) { text += String(other).text; return *this; }
+    String &operator+=(unsigned int other) { text += String(other).text; return *this; }
+    String &operator+=(long other) { text += String(other).text; return *this; }
+    String &operator+=(unsigned long other) { text += String(other).text; return *this; }
+
+private:
+    std::string text;
+
+    template<typename T> static std::string format(const char *pattern, T value) {
+        char buffer[64];
+        snprintf(buffer, sizeof buffer, pattern, value);
+        return buffer;
+    }
+    static std::string format(const char *pattern, int decimals, double value) {
+        char buffer[64];
+        snprintf(buffer, sizeof buffer, pattern, decimals, value);
+        return buffer;
+    }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t written = 0;
+        while (size--) written += write(*buffer++);
+        return written;
+    }
+    size_t write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+    size_t print(const char *text) { return write(text); }
+    size_t print(const String &text) { return write(text.c_str()); }
+    size_t print(char value) { return write((uint8_t)value); }
+    size_t print(int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+    template<typename T> size_t println(T value) { return print(value) + write('\n'); }
+    template<typename T> size_t println(T value, int format) { return print(value, format) + write('\n'); }
+    size_t println() { return write('\n'); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+// Writes to stdout
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) {}
+    size_t write(uint8_t value) { return fputc(value, stdout) != EOF; }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long milliseconds);
+void yield();
+
+#endif
@@ -0,0 +1,69 @@
+// The parts of ArduinoJson that AutoPayload uses: a document holding a
+// single "value" member, measured and serialized. Not a general replacement.
+#ifndef ARDUINO_JSON_H_
+#define ARDUINO_JSON_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#define JSON_OBJECT_SIZE(n) (16 * (n))
+
+class JsonValueStub {
+public:
+    JsonValueStub(std::string *text) : text(text) {}
+
+    void operator=(bool value) { *text = value ? "true" : "false"; }
+    void operator=(int value) { *text = std::to_string(value); }
+    void operator=(long value) { *text = std::to_string(value); }
+    void operator=(float value) { *text = format("%.7g", value); }
+    void operator=(double value) { *text = format("%.9g", value); }
+    void operator=(const char *value) {
+        *text = "\"";
+        for (; *value; value++) {
+            if (*value == '"' || *value == '\\') *text += '\\';
+            *text += *value;
+        }
+        *text += '"';
+    }
+
+private:
+    std::string *text;
+
+    static std::string format(const char *pattern, double value) {
+        char buffer[32];
+        snprintf(buffer, sizeof buffer, pattern, value);
+        return buffer;
+    }
+};
+
+template<size_t N> class StaticJsonDocument {
+public:
+    JsonValueStub operator[](const char *name) {
+        key = name;
+        return JsonValueStub(&text);
+    }
+
+    std::string serialize() const { return "{\"" + key + "\":" + text + "}"; }
+
+private:
+    std::string key;
+    std::string text;
+};
+
+template<size_t N> size_t measureJson(const StaticJsonDocument<N> &doc) {
+    return doc.serialize().size();
+}
+
+// Like ArduinoJson, writes as much as fits, terminated, and returns its length
+template<size_t N> size_t serializeJson(const StaticJsonDocument<N> &doc, char *out, size_t size) {
+    if (size == 0) return 0;
+    std::string json = doc.serialize();
+    size_t length = json.size() < size - 1 ? json.size() : size - 1;
+    memcpy(out, json.data(), length);
+    out[length] = 0;
+    return length;
+}
+
+#endif
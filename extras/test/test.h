@@ -0,0 +1,54 @@
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+
+// Checks keep going after a failure, so one run reports all of them.
+// End main() with "return testResult();".
+static int testFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_BYTES(expected, actual, size) \
+    do { \
+        if (memcmp((expected), (actual), (size)) != 0) { \
+            printf("%s:%d: bytes of %s differ from %s\n", __FILE__, __LINE__, #actual, #expected); \
+            testFailures++; \
+        } \
+    } while (0)
+
+inline int testResult() {
+    if (testFailures > 0) {
+        printf("%d checks failed\n", testFailures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
+
+// Nanoseconds per call of body, run iterations times. Benchmarks print
+// their results instead of checking them, as they depend on the host.
+template<typename F> double nanosecondsPer(unsigned long iterations, F body) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++) {
+        body(i);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+// Keeps the optimizer from dropping a benchmarked result
+template<typename T> void keep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif
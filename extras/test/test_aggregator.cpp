@@ -0,0 +1,59 @@
+#include "test.h"
+#include "SampleAggregator.h"
+#include "CborParser.h"
+
+#include <math.h>
+
+static void testStats() {
+    SampleAggregator aggregator(1000, 1, 2);
+    int asset = aggregator.addAsset("a");
+    CHECK(!aggregator.isComplete(0));
+    for (int i = 1; i <= 4; i++) {
+        aggregator.add(asset, 1e6f + i);
+    }
+    CborPayload payload;
+    CHECK(aggregator.isComplete(500));
+    CHECK(aggregator.emit(payload, 500));
+    aggregator.add(asset, 1e6f + 5);
+
+    SampleStats stats = aggregator.getStats(asset);
+    CHECK(stats.count == 5);
+    CHECK(stats.min == 1e6f + 1 && stats.max == 1e6f + 5);
+    CHECK(fabs(stats.mean - (1e6 + 3)) < 1e-6);
+    CHECK(fabs(stats.variance - 2.5) < 1e-6);
+
+    // The first slice has slid out
+    payload.reset();
+    CHECK(aggregator.emit(payload, 1000));
+    CHECK(aggregator.getStats(asset).count == 1);
+}
+
+// An asset that doesn't fit is left out, and the payload stays valid
+static void testPayloadFull() {
+    SampleAggregator aggregator(1000, 2);
+    int first = aggregator.addAsset("first");
+    int second = aggregator.addAsset("second");
+    aggregator.add(first, 1);
+    aggregator.add(second, 2);
+
+    CborPayload payload(80);
+    CHECK(!aggregator.emit(payload, 1000));
+
+    CborInput input(payload.getBytes(), payload.getSize());
+    CborParser parser(input);
+    CHECK(parser.next() && parser.type() == CBOR_TYPE_MAP && parser.asCount() == 1);
+    CHECK(parser.next() && parser.asStringView().equals("first"));
+    CHECK(parser.next() && parser.type() == CBOR_TYPE_MAP && parser.asCount() == 5);
+    CHECK(parser.skip());
+    CHECK(!parser.next() && parser.type() == CBOR_TYPE_END);
+
+    CborPayload empty;
+    CHECK(!aggregator.emit(empty, 2000));
+    CHECK(empty.getSize() == 0);
+}
+
+int main() {
+    testStats();
+    testPayloadFull();
+    return testResult();
+}
@@ -0,0 +1,92 @@
+// Built against stub/ArduinoJson.h, which serializes like ArduinoJson for
+// the single member documents AutoPayload uses
+#include "test.h"
+#include "AutoPayload.h"
+
+static const char *deviceId = "abcdefghijklmnopqrstuvwx";
+
+// MQTT PUBLISH size for a topic and payload
+static unsigned int messageSize(unsigned int topicLength, unsigned int payloadSize) {
+    unsigned int remaining = 2 + topicLength + payloadSize;
+    return 1 + (remaining < 128 ? 1 : 2) + remaining;
+}
+
+static void testCbor() {
+    AutoPayload payload;
+    CHECK(payload.set("t", 21));
+    CHECK(payload.set("on", true));
+    CHECK(payload.select(deviceId) == PAYLOAD_FORMAT_CBOR);
+
+    const unsigned char expected[] = {0xA2, 0x61, 't', 0x15, 0x62, 'o', 'n', 0xF5};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+
+    // Measured, but nothing counts as sent before the publish went through
+    AutoPayloadStats &stats = payload.getStats();
+    unsigned int cborSize = messageSize(7 + 24 + 6, sizeof expected);
+    unsigned int jsonSize = messageSize(7 + 24 + 7 + 1 + 6, 12) + messageSize(7 + 24 + 7 + 2 + 6, 14);
+    CHECK(stats.selections == 1 && stats.reused == 0);
+    CHECK(stats.measured[PAYLOAD_FORMAT_CBOR] == cborSize && stats.measured[PAYLOAD_FORMAT_JSON] == jsonSize);
+    CHECK(stats.measured[PAYLOAD_FORMAT_BINARY] == 0);
+    CHECK(stats.messages[PAYLOAD_FORMAT_CBOR] == 0 && stats.bytes[PAYLOAD_FORMAT_CBOR] == 0);
+
+    payload.recordPublished(deviceId);
+    CHECK(stats.messages[PAYLOAD_FORMAT_CBOR] == 1 && stats.bytes[PAYLOAD_FORMAT_CBOR] == cborSize);
+
+    // The same names and types reuse the format without measuring again
+    payload.reset();
+    CHECK(payload.set("t", 22));
+    CHECK(payload.set("on", false));
+    CHECK(payload.select(deviceId) == PAYLOAD_FORMAT_CBOR);
+    CHECK(stats.selections == 1 && stats.reused == 1);
+    CHECK(stats.messages[PAYLOAD_FORMAT_CBOR] == 1);
+
+    // Other types are a different set
+    payload.reset();
+    CHECK(payload.set("t", 22.5f));
+    CHECK(payload.set("on", false));
+    payload.select(deviceId);
+    CHECK(stats.selections == 2 && stats.reused == 1);
+}
+
+// Binary only once allowed, and then it's the smallest
+static void testBinary() {
+    AutoPayload payload;
+    payload.set("temperature", 21.5f);
+    CHECK(payload.select(deviceId) == PAYLOAD_FORMAT_CBOR);
+    payload.allowBinary(true);
+    CHECK(payload.select(deviceId) == PAYLOAD_FORMAT_BINARY);
+    const unsigned char expected[] = {0x41, 0xAC, 0x00, 0x00};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+    CHECK(payload.getStats().selections == 2);
+}
+
+// When CBOR doesn't fit, the values go as JSON, counted per published message
+static void testJson() {
+    AutoPayload payload(4);
+    payload.set("temperature", 21.5f);
+    payload.set("label", "kitchen");
+    CHECK(payload.select(deviceId) == PAYLOAD_FORMAT_JSON);
+    CHECK(payload.getCount() == 2);
+    CHECK(strcmp(payload.getAsset(1), "label") == 0);
+
+    char json[32];
+    CHECK(payload.writeJson(0, json, sizeof json) == 14 && strcmp(json, "{\"value\":21.5}") == 0);
+    CHECK(payload.writeJson(1, json, sizeof json) == 19 && strcmp(json, "{\"value\":\"kitchen\"}") == 0);
+    CHECK(payload.writeJson(1, json, 19) == 0);
+
+    // Only the message that went through counts
+    AutoPayloadStats &stats = payload.getStats();
+    CHECK(stats.messages[PAYLOAD_FORMAT_JSON] == 0);
+    payload.recordPublished(deviceId, 1);
+    CHECK(stats.messages[PAYLOAD_FORMAT_JSON] == 1);
+    CHECK(stats.bytes[PAYLOAD_FORMAT_JSON] == messageSize(7 + 24 + 7 + 5 + 6, 19));
+}
+
+int main() {
+    testCbor();
+    testBinary();
+    testJson();
+    return testResult();
+}
@@ -0,0 +1,44 @@
+#include "test.h"
+#include "CborBatch.h"
+#include "CborPayload.h"
+
+// Integer keys and names have ids of their own, even with the same text
+static void testKeys() {
+    const unsigned char message[] = {0xA3, 0x61, '3', 0x01, 0x03, 0x02, 0x61, '3', 0x04};
+    const unsigned char *messages[] = {message};
+    const unsigned int lengths[] = {sizeof message};
+    CborBatchDecoder decoder(16, 256);
+    CborBatch batch(8);
+    CHECK(decoder.decode(messages, lengths, 1, batch) == 1);
+    CHECK(batch.size == 3);
+    CHECK(batch.assets[0] != batch.assets[1] && batch.assets[0] == batch.assets[2]);
+    CHECK(!decoder.isDictionaryKey(batch.assets[0]) && decoder.isDictionaryKey(batch.assets[1]));
+    CHECK(strcmp(decoder.getAssetName(batch.assets[1]), "3") == 0);
+    CHECK(batch.integers[0] == 1 && batch.integers[1] == 2 && batch.integers[2] == 4);
+}
+
+static void testDataPoint() {
+    CborPayload payload;
+    payload.set((char *)"temperature", 21.5f);
+    payload.set((char *)"door", true);
+    payload.setTimestamp(1700000000);
+    payload.setLocation(GeoLocation(51.0f, 3.5f));
+
+    const unsigned char *messages[] = {payload.getBytes()};
+    const unsigned int lengths[] = {payload.getSize()};
+    CborBatchDecoder decoder;
+    CborBatch batch(8);
+    CHECK(decoder.decode(messages, lengths, 1, batch) == 1);
+    CHECK(batch.size == 2);
+    CHECK(strcmp(decoder.getAssetName(batch.assets[0]), "temperature") == 0);
+    CHECK(batch.types[0] == CBOR_VALUE_FLOAT && batch.numbers[0] == 21.5);
+    CHECK(batch.types[1] == CBOR_VALUE_BOOL && batch.integers[1] == 1);
+    CHECK(batch.timestamps[0] == 1700000000 && batch.timestamps[1] == 1700000000);
+    CHECK(batch.latitudes[1] == 51.0 && batch.longitudes[1] == 3.5);
+}
+
+int main() {
+    testKeys();
+    testDataPoint();
+    return testResult();
+}
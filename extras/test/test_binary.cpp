@@ -0,0 +1,206 @@
+// Also built as test_binary_portable, without __BYTE_ORDER__, to cover
+// the runtime byte order check
+#include "test.h"
+#include "BinaryPayload.h"
+#include "BinaryReader.h"
+#include "BinarySeries.h"
+
+static void testBigEndian() {
+    BinaryPayload payload(64);
+    CHECK(payload.add((int16_t)0x0102));
+    CHECK(payload.add((uint32_t)0x03040506));
+    CHECK(payload.add((uint64_t)0x0708090A0B0C0D0EULL));
+    CHECK(payload.add(1.0f));
+    CHECK(payload.add(true));
+    const int16_t samples[] = {0x1112, -2};
+    CHECK(payload.addArray(samples, 2));
+    CHECK(payload.add((const char *)"ok"));
+
+    const unsigned char expected[] = {
+        0x01, 0x02,
+        0x03, 0x04, 0x05, 0x06,
+        0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+        0x3F, 0x80, 0x00, 0x00,
+        0x01,
+        0x11, 0x12, 0xFF, 0xFE,
+        'o', 'k'};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+
+    BinaryReader reader(payload.getBytes(), payload.getSize());
+    int16_t a;
+    uint32_t b;
+    uint64_t c;
+    float d;
+    bool e;
+    int16_t f[2];
+    CHECK(reader.read(a) && a == 0x0102);
+    CHECK(reader.read(b) && b == 0x03040506);
+    CHECK(reader.read(c) && c == 0x0708090A0B0C0D0EULL);
+    CHECK(reader.read(d) && d == 1.0f);
+    CHECK(reader.read(e) && e);
+    CHECK(reader.read(f[0]) && reader.read(f[1]) && f[0] == 0x1112 && f[1] == -2);
+    CHECK(reader.getRemaining() == 2);
+}
+
+static void testArrayFits() {
+    BinaryPayload payload(5);
+    const int16_t samples[] = {1, 2, 3};
+    CHECK(!payload.addArray(samples, 3));
+    CHECK(payload.getSize() == 0);
+    CHECK(payload.addArray(samples, 2));
+    CHECK(payload.getSize() == 4);
+}
+
+// Bit fields share bytes with each other, but not with byte-aligned values
+static void testBits() {
+    BinaryPayload payload(32);
+    CHECK(payload.add((uint8_t)0xAB));
+    CHECK(payload.addBits(5, 3));
+    CHECK(payload.addBits(0x1FF, 9));
+    CHECK(payload.add((uint16_t)0x1234));
+    CHECK(payload.addBits(0xDEADBEEF, 32));
+    CHECK(payload.addBits(1, 1));
+    CHECK(payload.addBits(0x12345678, 32));
+    CHECK(payload.addBits(0xFF, 3));
+    CHECK(!payload.addBits(1, 0));
+    CHECK(!payload.addBits(1, 33));
+
+    const unsigned char expected[] = {
+        0xAB,
+        0xBF, 0xF0,
+        0x12, 0x34,
+        0xDE, 0xAD, 0xBE, 0xEF,
+        0x89, 0x1A, 0x2B, 0x3C, 0x70};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+
+    BinaryReader reader(payload.getBytes(), payload.getSize());
+    uint8_t byte;
+    uint16_t word;
+    uint32_t bits;
+    CHECK(reader.read(byte) && byte == 0xAB);
+    CHECK(reader.readBits(bits, 3) && bits == 5);
+    CHECK(reader.readBits(bits, 9) && bits == 0x1FF);
+    CHECK(reader.read(word) && word == 0x1234);
+    CHECK(reader.readBits(bits, 32) && bits == 0xDEADBEEF);
+    CHECK(reader.readBits(bits, 1) && bits == 1);
+    CHECK(reader.readBits(bits, 32) && bits == 0x12345678);
+    CHECK(reader.readBits(bits, 3) && bits == 7);
+    CHECK(!reader.readBits(bits, 0) && !reader.readBits(bits, 33));
+    CHECK(reader.getRemaining() == 0);
+}
+
+// The last bits of a payload can be filled exactly, and nothing more fits
+static void testBitsCapacity() {
+    BinaryPayload payload(3);
+    CHECK(payload.addBits(0xABCDE, 20));
+    CHECK(payload.getFreeBits() == 4);
+    CHECK(!payload.addBits(0, 5));
+    CHECK(payload.addBits(0xF, 4));
+    CHECK(payload.getFreeBits() == 0);
+    CHECK(!payload.addBits(1, 1));
+    CHECK(!payload.add((uint8_t)1));
+    CHECK(payload.getSize() == 3);
+
+    const unsigned char expected[] = {0xAB, 0xCD, 0xEF};
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+
+    BinaryReader reader(payload.getBytes(), payload.getSize());
+    uint32_t bits = 42;
+    CHECK(!reader.readBits(bits, 25) && bits == 42);
+    CHECK(reader.readBits(bits, 20) && bits == 0xABCDE);
+    CHECK(!reader.readBits(bits, 5) && bits == 0xABCDE);
+    CHECK(reader.readBits(bits, 4) && bits == 0xF);
+    CHECK(!reader.readBits(bits, 1));
+
+    // A full 32 bits right at the end
+    BinaryPayload exact(4);
+    CHECK(exact.addBits(0x80000001, 32));
+    CHECK(!exact.addBits(0, 1));
+    BinaryReader exactReader(exact.getBytes(), exact.getSize());
+    CHECK(exactReader.readBits(bits, 32) && bits == 0x80000001);
+}
+
+// Writes samples starting at start, one every 10 seconds with a few
+// irregular gaps, and reads them back
+static void checkSeriesRoundTrip(uint32_t start) {
+    BinaryPayload payload(256);
+    BinarySeriesWriter writer(payload);
+    uint32_t timestamps[20];
+    float values[20];
+    for (int i = 0; i < 20; i++) {
+        timestamps[i] = start + i * 10 + (i % 7 == 3 ? 5 : 0);
+        values[i] = 21.5f + (i % 4) * 0.25f;
+        CHECK(writer.add(timestamps[i], values[i]));
+    }
+    CHECK(writer.finish());
+
+    BinaryReader reader(payload.getBytes(), payload.getSize());
+    BinarySeriesReader series(reader);
+    uint32_t timestamp;
+    float value;
+    for (int i = 0; i < 20; i++) {
+        CHECK(series.next(timestamp, value));
+        CHECK(timestamp == timestamps[i] && value == values[i]);
+    }
+    CHECK(!series.next(timestamp, value) && !series.hasError());
+}
+
+static void testSeries() {
+    checkSeriesRoundTrip(1700000000);
+    // Starts whose top 5 bits are all ones, like the end marker
+    checkSeriesRoundTrip(0xF8000000);
+    checkSeriesRoundTrip(0xFFFFFF00);
+
+    BinaryPayload payload(16);
+    BinarySeriesWriter writer(payload);
+    CHECK(writer.finish());
+    BinaryReader reader(payload.getBytes(), payload.getSize());
+    BinarySeriesReader empty(reader);
+    uint32_t timestamp;
+    float value;
+    CHECK(!empty.next(timestamp, value) && !empty.hasError());
+
+    // Cut short inside the first sample
+    BinaryPayload single(16);
+    BinarySeriesWriter one(single);
+    CHECK(one.add(0xFFFFFFFF, 1.0f) && one.finish());
+    BinaryReader truncated(single.getBytes(), 5);
+    BinarySeriesReader cut(truncated);
+    CHECK(!cut.next(timestamp, value) && cut.hasError());
+}
+
+// Intervals that jump across the whole 32-bit range, whose change doesn't
+// fit an int32_t, still round-trip
+static void testSeriesJumps() {
+    const uint32_t timestamps[] = {
+        0, 0x7FFFFFFF, 0xFFFFFFFE, 0, 0x80000000, 0x80000000, 0xFFFFFFFF, 1, 0x7FFFFFFF, 0x80000009};
+    const unsigned int count = sizeof timestamps / sizeof timestamps[0];
+    BinaryPayload payload(128);
+    BinarySeriesWriter writer(payload);
+    for (unsigned int i = 0; i < count; i++) {
+        CHECK(writer.add(timestamps[i], (float)i));
+    }
+    CHECK(writer.finish());
+
+    BinaryReader reader(payload.getBytes(), payload.getSize());
+    BinarySeriesReader series(reader);
+    uint32_t timestamp;
+    float value;
+    for (unsigned int i = 0; i < count; i++) {
+        CHECK(series.next(timestamp, value));
+        CHECK(timestamp == timestamps[i] && value == (float)i);
+    }
+    CHECK(!series.next(timestamp, value) && !series.hasError());
+}
+
+int main() {
+    testBigEndian();
+    testArrayFits();
+    testBits();
+    testBitsCapacity();
+    testSeries();
+    testSeriesJumps();
+    return testResult();
+}
@@ -0,0 +1,119 @@
+#include "test.h"
+#include "CborPayload.h"
+
+#include <vector>
+
+static void testComplete() {
+    CborPayload payload;
+    CborBuilder accel = payload.setObject((char *)"a", 2);
+    CHECK(accel.set((char *)"x", 1));
+    CborBuilder inner = accel.addArray(1);
+    CHECK(!inner.isValid());
+    inner = accel.setArray((char *)"y", 2);
+    CHECK(inner.add(2));
+    CHECK(inner.add(3));
+    CHECK(!inner.add(4));
+    CHECK(accel.end());
+    CHECK(!accel.end());
+    CHECK(!accel.set((char *)"z", 5));
+
+    const unsigned char expected[] = {0xA1, 0x61, 'a', 0xA2, 0x61, 'x', 0x01, 0x61, 'y', 0x82, 0x02, 0x03};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+}
+
+// Missing items anywhere in the asset take the whole asset out
+static void testUnderfilled() {
+    CborPayload payload;
+    payload.set((char *)"t", 1);
+    CborBuilder outer = payload.setArray((char *)"w", 2);
+    CborBuilder inner = outer.addArray(2);
+    inner.add(1);
+    outer.add(2);
+    CHECK(!outer.end());
+
+    CborBuilder window = payload.setArray((char *)"v", 2);
+    window.add(1);
+    payload.set((char *)"u", 2);
+    CHECK(!window.add(2));
+    CHECK(!window.isValid());
+
+    const unsigned char expected[] = {0xA2, 0x61, 't', 0x01, 0x61, 'u', 0x02};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+}
+
+// A container that ran out of room is rolled back, and later assets still fit
+static void testOverflow() {
+    CborPayload payload(16);
+    payload.set((char *)"t", 1);
+    CborBuilder window = payload.setArray((char *)"w", 8);
+    for (int i = 0; i < 8; i++) {
+        window.add(1000);
+    }
+    CHECK(!window.end());
+    CHECK(payload.set((char *)"u", 2));
+
+    const unsigned char expected[] = {0xA2, 0x61, 't', 0x01, 0x61, 'u', 0x02};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+
+    // Not ended explicitly, so getBytes() does it
+    payload.reset();
+    CborBuilder full = payload.setArray((char *)"f", 1);
+    full.add(7);
+    const unsigned char ended[] = {0xA1, 0x61, 'f', 0x81, 0x07};
+    CHECK(payload.getSize() == sizeof ended);
+    CHECK_BYTES(ended, payload.getBytes(), sizeof ended);
+    CHECK(!full.isValid());
+}
+
+// A parent can't write while its child is open, nor can a child that's full
+static void testNesting() {
+    CborPayload payload;
+    CborBuilder outer = payload.setArray((char *)"n", 3);
+    CborBuilder first = outer.addArray(2);
+    CHECK(!outer.add(9));
+    CHECK(first.add(1));
+    CHECK(!outer.add(9));
+    CHECK(first.add(2));
+    CHECK(!first.add(3));
+    CborBuilder second = outer.addArray(1);
+    CHECK(!first.add(3));
+    CborBuilder empty = second.addObject(0);
+    CHECK(!empty.set((char *)"e", 0));
+    CHECK(!second.add(9));
+    CHECK(outer.add(4));
+    CHECK(outer.end());
+
+    const unsigned char expected[] = {0xA1, 0x61, 'n', 0x83, 0x82, 0x01, 0x02, 0x81, 0xA0, 0x04};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+}
+
+// Nesting deeper than CBOR_BUILDER_DEPTH fails, the container itself can still be filled
+static void testDepth() {
+    CborPayload payload;
+    std::vector<CborBuilder> builders;
+    builders.push_back(payload.setArray((char *)"d", 2));
+    for (int i = 1; i < CBOR_BUILDER_DEPTH; i++) {
+        builders.push_back(builders.back().addArray(2));
+        CHECK(builders.back().isValid());
+    }
+    CHECK(!builders.back().addArray(2).isValid());
+    CHECK(builders.back().add(1));
+    for (int i = CBOR_BUILDER_DEPTH - 1; i >= 0; i--) {
+        CHECK(builders[i].add(i));
+    }
+    CHECK(builders[0].end());
+    CHECK(payload.getSize() == 4 + 2 * CBOR_BUILDER_DEPTH);
+}
+
+int main() {
+    testComplete();
+    testUnderfilled();
+    testOverflow();
+    testNesting();
+    testDepth();
+    return testResult();
+}
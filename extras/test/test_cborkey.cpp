@@ -0,0 +1,107 @@
+#include "test.h"
+#include "CborAssetDictionary.h"
+#include "CborPayload.h"
+
+#include <string>
+
+static_assert(CborKey::hashName("ab", 2) == 'a' * 16777619u + 'b', "hash of a short name");
+
+static constexpr char padded[32] = "temperature";
+static_assert(CborKey::measure("ab\0cd", 5) == 2, "stops at the first NUL");
+static_assert(CborKey::measure("abcde", 5) == 5, "no NUL within the length");
+static_assert(CborKey(padded).length == 11, "trailing NULs aren't part of the name");
+static_assert(CborKey(padded).hash == CborKey("temperature").hash, "nor of the hash");
+
+static const char name23[24] = "abcdefghijklmnopqrstuvw";
+static char name24[25];
+static char name255[256];
+static char name256[257];
+static char name65535[65536];
+
+static void fill(char *name, unsigned int length) {
+    memset(name, 'k', length);
+    name[length] = 0;
+}
+
+// The header has to match what writeString() produces for the same length
+static void checkHeader(const CborKey &key) {
+    unsigned char expected[8];
+    CborStaticOutput output(expected, sizeof expected);
+    CborWriter writer(output);
+    writer.writeInt((uint32_t)key.length);
+    expected[0] = (expected[0] & 0x1F) | 0x60;
+    CHECK(key.headerSize == output.getSize());
+    CHECK_BYTES(expected, key.header, key.headerSize);
+}
+
+static void testHeaders() {
+    fill(name24, 24);
+    fill(name255, 255);
+    fill(name256, 256);
+    fill(name65535, 65535);
+    checkHeader(CborKey(""));
+    checkHeader(CborKey(name23));
+    checkHeader(CborKey(name24));
+    checkHeader(CborKey(name255));
+    checkHeader(CborKey(name256));
+    checkHeader(CborKey(name65535));
+}
+
+static void testPayload() {
+    constexpr CborKey temperature("temperature");
+    CborPayload byName;
+    CborPayload byKey;
+    byName.set((char *)"temperature", 21.5f);
+    byKey.set(temperature, 21.5f);
+    CHECK(byKey.getSize() == byName.getSize());
+    CHECK_BYTES(byName.getBytes(), byKey.getBytes(), byName.getSize());
+}
+
+// Keys are found by hash, whether or not the dictionary has the same pointer
+static void testDictionary() {
+    constexpr CborKey temperature("temperature");
+    constexpr CborKey humidity("humidity");
+    std::string copy = "temperature";
+    CborAssetDictionary dictionary;
+    dictionary.add("pressure");
+    dictionary.add(copy.c_str());
+    CHECK(dictionary.find(temperature) == 1);
+    CHECK(dictionary.find(humidity) == -1);
+    CHECK(dictionary.add(temperature.name) == 1);
+
+    dictionary.add(humidity.name);
+    CHECK(dictionary.find(humidity) == 2);
+
+    CborPayload payload;
+    payload.setDictionary(&dictionary);
+    payload.set(humidity, 40);
+    const unsigned char expected[] = {0xA1, 0x02, 0x18, 40};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+}
+
+// A name copied into a larger buffer at run time gives the same key
+static void testBuffer() {
+    char buffer[32];
+    strcpy(buffer, "temperature");
+    CborKey key(buffer);
+    constexpr CborKey literal("temperature");
+    CHECK(key.length == literal.length);
+    CHECK(key.hash == literal.hash);
+    CHECK(key.headerSize == literal.headerSize);
+    CHECK_BYTES(literal.header, key.header, literal.headerSize);
+
+    static char long300[300];
+    fill(long300, 280);
+    CborKey longKey(long300);
+    CHECK(longKey.length == 280);
+    checkHeader(longKey);
+}
+
+int main() {
+    testHeaders();
+    testBuffer();
+    testPayload();
+    testDictionary();
+    return testResult();
+}
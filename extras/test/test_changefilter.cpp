@@ -0,0 +1,90 @@
+#include "test.h"
+#include "ChangeFilter.h"
+
+#include <string>
+
+// What the device does around a publish that goes through
+template<typename T> static bool send(ChangeFilter &filter, const char *asset, T value, unsigned long now) {
+    if (!filter.check(asset, value, now)) {
+        filter.suppress(asset);
+        return false;
+    }
+    filter.commit(asset, value, now);
+    return true;
+}
+
+static void testDeadbands() {
+    ChangeFilter filter;
+    CHECK(filter.add("t", 0.5, 0.1));
+    CHECK(send(filter, "t", 20, 0));
+    CHECK(!send(filter, "t", 21.9, 1));      // within 10% of 20
+    CHECK(send(filter, "t", 22.1, 2));
+    CHECK(send(filter, "other", 1, 3));      // no filter
+    CHECK(filter.getStats().sent == 2 && filter.getStats().suppressed == 1);
+}
+
+static void testIntervals() {
+    ChangeFilter filter;
+    CHECK(filter.add("t", 1, 0, 100, 1000));
+    CHECK(send(filter, "t", 0.0, 0));
+    CHECK(!send(filter, "t", 5, 50));        // too soon
+    CHECK(send(filter, "t", 5, 100));
+    CHECK(!send(filter, "t", 5, 900));
+    CHECK(send(filter, "t", 5, 1100));       // heartbeat
+}
+
+// "s618190" and "s31597" have the same 32-bit FNV-1a hash
+static void testText() {
+    ChangeFilter filter;
+    CHECK(filter.add("state", 0));
+    CHECK(send(filter, "state", "s618190", 0));
+    CHECK(!send(filter, "state", "s618190", 1));
+    CHECK(send(filter, "state", "s31597", 2));
+    CHECK(send(filter, "state", "", 3));
+    CHECK(!send(filter, "state", "", 4));
+
+    // Longer than what's kept: the end still counts through length and hash
+    std::string text(CHANGE_FILTER_TEXT_LENGTH + 10, 'x');
+    CHECK(send(filter, "state", text.c_str(), 5));
+    CHECK(!send(filter, "state", text.c_str(), 6));
+    text[text.size() - 1] = 'y';
+    CHECK(send(filter, "state", text.c_str(), 7));
+    text.push_back('y');
+    CHECK(send(filter, "state", text.c_str(), 8));
+    CHECK(send(filter, "state", "x", 9));
+}
+
+// A value that couldn't be sent isn't remembered, so the same one passes again
+static void testFailedSend() {
+    ChangeFilter filter;
+    CHECK(filter.add("t", 1, 0, 100));
+    CHECK(filter.add("state", 0));
+    CHECK(send(filter, "t", 20.0, 0));
+    CHECK(filter.check("t", 25.0, 200));
+    CHECK(filter.check("t", 25.0, 300));
+    CHECK(filter.getStats().sent == 1 && filter.getStats().suppressed == 0);
+    filter.commit("t", 25.0, 300);
+    CHECK(!filter.check("t", 25.0, 450));
+    CHECK(!filter.check("t", 20.0, 350));      // minInterval since the commit
+    CHECK(filter.getStats("t").sent == 2);
+
+    CHECK(filter.check("state", "on", 0));
+    CHECK(filter.check("state", "on", 1));
+    filter.commit("state", "on", 1);
+    CHECK(!filter.check("state", "on", 2));
+    filter.suppress("state");
+    CHECK(filter.getStats("state").sent == 1 && filter.getStats("state").suppressed == 1);
+
+    // Without a filter nothing is counted
+    filter.commit("other", 1.0, 0);
+    filter.suppress("other");
+    CHECK(filter.getStats().sent == 3 && filter.getStats().suppressed == 1);
+}
+
+int main() {
+    testDeadbands();
+    testIntervals();
+    testText();
+    testFailedSend();
+    return testResult();
+}
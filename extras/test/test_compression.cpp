@@ -0,0 +1,114 @@
+#include "test.h"
+#include "PayloadCompression.h"
+
+#include <stdlib.h>
+#include <vector>
+
+// Compresses into exactly capacity bytes, checking nothing is written past them
+static unsigned int compress(const unsigned char *data, unsigned int size, std::vector<unsigned char> &out, unsigned int capacity) {
+    out.assign(capacity + 4, 0xAA);
+    unsigned int compressed = compressPayload(data, size, out.data(), capacity);
+    for (unsigned int i = capacity; i < capacity + 4; i++) {
+        CHECK(out[i] == 0xAA);
+    }
+    return compressed;
+}
+
+static void checkRoundTrip(const unsigned char *data, unsigned int size, unsigned int capacity) {
+    std::vector<unsigned char> compressed;
+    unsigned int compressedSize = compress(data, size, compressed, capacity);
+    CHECK(compressedSize > 0 && compressedSize <= capacity);
+    std::vector<unsigned char> restored(size + 1);
+    CHECK(decompressPayload(compressed.data(), compressedSize, restored.data(), size) == (int)size);
+    CHECK_BYTES(data, restored.data(), size);
+}
+
+static void testEmpty() {
+    unsigned char out[4];
+    CHECK(compressPayload(out, 0, out, sizeof out) == 0);
+    CHECK(decompressPayload(out, 0, out, sizeof out) == 0);
+}
+
+// Repeats shrink, and come back the same
+static void testRepetitive() {
+    unsigned char data[300];
+    for (unsigned int i = 0; i < sizeof data; i++) {
+        data[i] = "temperature"[i % 11];
+    }
+    std::vector<unsigned char> compressed;
+    unsigned int compressedSize = compress(data, sizeof data, compressed, sizeof data);
+    CHECK(compressedSize > 0 && compressedSize < sizeof data / 4);
+    checkRoundTrip(data, sizeof data, sizeof data);
+}
+
+// Random bytes grow by a bit per byte: they don't fit in their own size,
+// but do round-trip given the room
+static void testIncompressible() {
+    unsigned char data[256];
+    srand(7);
+    for (unsigned int i = 0; i < sizeof data; i++) {
+        data[i] = rand();
+    }
+    std::vector<unsigned char> compressed;
+    CHECK(compress(data, sizeof data, compressed, sizeof data) == 0);
+    checkRoundTrip(data, sizeof data, sizeof data * 9 / 8 + 1);
+}
+
+// Output is limited to capacity on both sides
+static void testCapacity() {
+    unsigned char data[64];
+    memset(data, 'x', sizeof data);
+    std::vector<unsigned char> compressed;
+    unsigned int compressedSize = compress(data, sizeof data, compressed, sizeof data);
+    CHECK(compressedSize > 0);
+    for (unsigned int capacity = 0; capacity < compressedSize; capacity++) {
+        CHECK(compress(data, sizeof data, compressed, capacity) == 0);
+    }
+    compress(data, sizeof data, compressed, sizeof data);
+
+    unsigned char restored[sizeof data];
+    CHECK(decompressPayload(compressed.data(), compressedSize, restored, sizeof data - 1) == -1);
+    CHECK(decompressPayload(compressed.data(), compressedSize, restored, 0) == -1);
+}
+
+static void testCorrupt() {
+    unsigned char out[32];
+    // A literal 'A': 1 01000001, padded with zeros
+    const unsigned char literal[] = {0xA0, 0x80};
+    CHECK(decompressPayload(literal, sizeof literal, out, sizeof out) == 1 && out[0] == 'A');
+    // The same, cut short
+    CHECK(decompressPayload(literal, 1, out, sizeof out) == -1);
+    // Padding that isn't zero
+    const unsigned char padding[] = {0xA0, 0x81};
+    CHECK(decompressPayload(padding, sizeof padding, out, sizeof out) == -1);
+    // A back-reference before anything was written
+    const unsigned char reference[] = {0x00, 0x08};
+    CHECK(decompressPayload(reference, sizeof reference, out, sizeof out) == -1);
+    // A back-reference reaching further back than the output
+    const unsigned char tooFar[] = {0xA0, 0x80, 0x80, 0x08};
+    CHECK(decompressPayload(tooFar, sizeof tooFar, out, sizeof out) == -1);
+
+    // Every cut of a real stream either fails or gives a prefix of the input
+    unsigned char data[100];
+    for (unsigned int i = 0; i < sizeof data; i++) {
+        data[i] = i % 7 == 0 ? i : 'a';
+    }
+    std::vector<unsigned char> compressed;
+    unsigned int compressedSize = compress(data, sizeof data, compressed, sizeof data);
+    CHECK(compressedSize > 0);
+    unsigned char restored[sizeof data];
+    for (unsigned int cut = 1; cut < compressedSize; cut++) {
+        int restoredSize = decompressPayload(compressed.data(), cut, restored, sizeof restored);
+        CHECK(restoredSize < (int)sizeof data);
+        CHECK(restoredSize == -1 || memcmp(data, restored, restoredSize) == 0);
+    }
+}
+
+int main() {
+    testEmpty();
+    testRepetitive();
+    testIncompressible();
+    testCapacity();
+    testCorrupt();
+    return testResult();
+}
@@ -0,0 +1,110 @@
+#include "test.h"
+#include "CborAssetDictionary.h"
+#include "CborPayload.h"
+#include "CborParser.h"
+
+#include <vector>
+#include <string>
+
+// getEncodedSize() has to match what write() produces, for every header size
+static void testEncodedSize() {
+    const unsigned int counts[] = {0, 1, 23, 24, 255, 256, 65537};
+    std::vector<std::string> names;
+    for (unsigned int i = 0; i < 65537; i++) {
+        names.push_back(std::to_string(i) + std::string(i % 300, 'n'));
+    }
+    for (unsigned int c = 0; c < sizeof counts / sizeof counts[0]; c++) {
+        CborAssetDictionary dictionary(counts[c]);
+        for (unsigned int i = 0; i < counts[c]; i++) {
+            CHECK(dictionary.add(names[i].c_str()) == (int)i);
+        }
+        std::vector<unsigned char> bytes(counts[c] * 310 + 16);
+        CborStaticOutput output(&bytes[0], bytes.size());
+        CborWriter writer(output);
+        dictionary.write(writer);
+        CHECK(dictionary.getEncodedSize() == output.getSize());
+
+        CborInput input(output.getData(), output.getSize());
+        CborParser parser(input);
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_MAP && parser.asCount() == counts[c]);
+        for (unsigned int i = 0; i < counts[c]; i++) {
+            CHECK(parser.next() && parser.asUnsigned() == i);
+            CHECK(parser.next() && parser.asStringView().equals(names[i].c_str()));
+        }
+    }
+}
+
+static void testKeys() {
+    CborAssetDictionary dictionary(2);
+    CHECK(dictionary.add("relay-msg-sensor-example") == 0);
+    CHECK(dictionary.add("temperature") == 1);
+    CHECK(dictionary.add("humidity") == -1);
+    CHECK(dictionary.add("temperature") == 1);
+
+    CborPayload payload;
+    payload.setDictionary(&dictionary);
+    CHECK(payload.getDictionary() == &dictionary);
+    payload.set((char *)"humidity", 40);
+    CHECK(!payload.usesDictionaryKeys());
+    payload.set((char *)"temperature", 21);
+    CHECK(payload.usesDictionaryKeys());
+
+    const unsigned char expected[] = {0xA2, 0x68, 'h', 'u', 'm', 'i', 'd', 'i', 't', 'y', 0x18, 40, 0x01, 21};
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+
+    payload.reset();
+    CHECK(!payload.usesDictionaryKeys());
+}
+
+// Collects what's written, and counts the calls
+class Sink : public Print {
+public:
+    std::string bytes;
+    unsigned int writes = 0;
+
+    virtual size_t write(uint8_t value) {
+        writes++;
+        bytes.push_back((char)value);
+        return 1;
+    }
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        writes++;
+        bytes.append((const char *)buffer, size);
+        return size;
+    }
+};
+
+// Streaming gives the same bytes as writing into a buffer, a chunk at a time
+static void testStreamed() {
+    std::vector<std::string> names;
+    for (unsigned int i = 0; i < 40; i++) {
+        names.push_back("asset-" + std::to_string(i) + std::string(i % 3 ? 2 : 40, 'n'));
+    }
+    CborAssetDictionary dictionary(40);
+    for (unsigned int i = 0; i < 40; i++) {
+        dictionary.add(names[i].c_str());
+    }
+    unsigned int size = dictionary.getEncodedSize();
+    std::vector<unsigned char> bytes(size);
+    CborStaticOutput output(&bytes[0], size);
+    CborWriter writer(output);
+    dictionary.write(writer);
+
+    Sink sink;
+    CborPrintOutput printOutput(sink);
+    CborWriter printWriter(printOutput);
+    dictionary.write(printWriter);
+    CHECK(printOutput.flush() == size);
+    CHECK(printOutput.flush() == size);
+    CHECK(sink.bytes.size() == size);
+    CHECK_BYTES(&bytes[0], sink.bytes.data(), size);
+    CHECK(sink.writes < size / 8);
+}
+
+int main() {
+    testEncodedSize();
+    testStreamed();
+    testKeys();
+    return testResult();
+}
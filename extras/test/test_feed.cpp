@@ -0,0 +1,133 @@
+// Feeding a message in pieces has to give the same events as feeding it
+// whole, wherever it's split
+#include "test.h"
+#include "CborDecoder.h"
+#include "CborEncoder.h"
+
+#include <string>
+#include <vector>
+
+class LogListener : public CborListener {
+public:
+    std::string log;
+    bool ownsBytes = true;
+
+    void add(const char *kind, const std::string &value) {
+        log += kind;
+        log += '(';
+        log += value;
+        log += ')';
+    }
+    virtual void OnInteger(int32_t value) { add("int", std::to_string(value)); }
+    virtual void OnBytes(unsigned char *data, unsigned int size) {
+        add("bytes", std::string((const char *)data, size));
+        if (ownsBytes) delete[] data;
+    }
+    virtual void OnString(String &str) { add("string", str.c_str()); }
+    virtual void OnArray(unsigned int size) { add("array", std::to_string(size)); }
+    virtual void OnMap(unsigned int size) { add("map", std::to_string(size)); }
+    virtual void OnTag(uint32_t tag) { add("tag", std::to_string(tag)); }
+    virtual void OnSpecial(uint32_t code) { add("special", std::to_string(code)); }
+    virtual void OnError(const char *error) { add("error", error); }
+    virtual void OnFloat(double value) { add("float", std::to_string(value)); }
+    virtual void OnExtraInteger(uint64_t value, int sign) { add(sign < 0 ? "-extra" : "extra", std::to_string(value)); }
+    virtual void OnExtraTag(uint64_t tag) { add("extratag", std::to_string(tag)); }
+};
+
+static std::vector<unsigned char> message() {
+    static unsigned char buffer[1024];
+    CborStaticOutput output(buffer, sizeof buffer);
+    CborWriter writer(output);
+    std::string longText(300, 't');
+    const unsigned char blob[] = {1, 2, 3, 0, 5};
+
+    writer.writeTag(120);
+    writer.writeArray(2);
+    writer.writeMap(9);
+    writer.writeString("small", 5);
+    writer.writeInt((int32_t)7);
+    writer.writeString("wide", 4);
+    writer.writeInt((int32_t)-100000);
+    writer.writeString("huge", 4);
+    writer.writeInt((uint64_t)1 << 40);
+    writer.writeString("text", 4);
+    writer.writeString(longText.c_str(), longText.length());
+    writer.writeString("blob", 4);
+    writer.writeBytes(blob, sizeof blob);
+    writer.writeString("float", 5);
+    writer.writeFloat(21.5f);
+    writer.writeString("double", 6);
+    writer.writeDouble(-0.1);
+    writer.writeString("flag", 4);
+    writer.writeSpecial(21);
+    writer.writeString("list", 4);
+    writer.writeArray(3);
+    writer.writeInt((int32_t)300);
+    writer.writeSpecial(22);
+    writer.writeString("", 0);
+    writer.writeTag(1);
+    writer.writeInt((uint32_t)1700000000);
+    return std::vector<unsigned char>(buffer, buffer + output.getSize());
+}
+
+static std::string feed(CborReader &reader, LogListener &listener, const std::vector<unsigned char> &bytes,
+        unsigned int first, unsigned int second) {
+    listener.log.clear();
+    reader.Reset();
+    reader.Feed(&bytes[0], first);
+    reader.Feed(&bytes[0] + first, second - first);
+    reader.Feed(&bytes[0] + second, bytes.size() - second);
+    return listener.log;
+}
+
+static void testSplits(bool limited) {
+    std::vector<unsigned char> bytes = message();
+    LogListener listener;
+    listener.ownsBytes = !limited;
+    CborReader reader(listener);
+    static unsigned char scratch[512];
+    if (limited) {
+        CHECK(reader.SetLimits(400, 4, 100, scratch, sizeof scratch));
+    }
+
+    std::string whole = feed(reader, listener, bytes, bytes.size(), bytes.size());
+    CHECK(whole.find("error") == std::string::npos);
+    CHECK(whole.find(std::string(300, 't')) != std::string::npos);
+
+    unsigned int failures = 0;
+    for (unsigned int first = 0; first <= bytes.size(); first++) {
+        for (unsigned int second = first; second <= bytes.size(); second++) {
+            if (feed(reader, listener, bytes, first, second) != whole && failures++ == 0) {
+                printf("split at %u and %u differs:\n%s\n%s\n", first, second, listener.log.c_str(), whole.c_str());
+            }
+        }
+    }
+    CHECK(failures == 0);
+}
+
+// A length straight off the wire mustn't be allocated up front
+static void testHugeLength() {
+    const unsigned char header[] = {0x5A, 0xFF, 0xFF, 0xFF, 0xF0, 'a', 'b'};
+    LogListener listener;
+    CborReader reader(listener);
+    reader.Feed(header, sizeof header);
+    CHECK(listener.log == "error(string too long to carry)");
+
+    // Up to the limit it's carried
+    std::vector<unsigned char> text(3 + CBOR_READER_MAX_CARRY, 'x');
+    text[0] = 0x79;
+    text[1] = CBOR_READER_MAX_CARRY >> 8;
+    text[2] = CBOR_READER_MAX_CARRY & 0xFF;
+    listener.log.clear();
+    reader.Reset();
+    reader.Feed(&text[0], 10);
+    reader.Feed(&text[10], text.size() - 10);
+    CHECK(listener.log == "string(" + std::string(CBOR_READER_MAX_CARRY, 'x') + ")");
+}
+
+int main() {
+    testSplits(false);
+    testSplits(true);
+    testHugeLength();
+    return testResult();
+}
@@ -0,0 +1,128 @@
+#include "test.h"
+#include "CborJson.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+class StringPrint : public Print {
+public:
+    std::string text;
+    virtual size_t write(uint8_t value) {
+        text += (char)value;
+        return 1;
+    }
+};
+
+static std::vector<unsigned char> fromHex(const char *hex) {
+    std::vector<unsigned char> bytes;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned int byte;
+        sscanf(hex, "%2x", &byte);
+        bytes.push_back(byte);
+    }
+    return bytes;
+}
+
+// NULL expected means the transcode has to fail
+static void check(const char *hex, const char *json, const char *diagnostic) {
+    for (int mode = 0; mode < 2; mode++) {
+        const char *expected = mode ? diagnostic : json;
+        std::vector<unsigned char> bytes = fromHex(hex);
+        CborInput input(&bytes[0], bytes.size());
+        StringPrint out;
+        CborJsonTranscoder transcoder(out, mode == 1);
+        bool ok = transcoder.transcode(input);
+        if (expected == NULL ? ok : !ok || out.text != expected) {
+            printf("%s %s: got \"%s\"%s%s\n", hex, mode ? "diagnostic" : "JSON", out.text.c_str(),
+                ok ? "" : ", failed: ", ok ? "" : transcoder.getError());
+            testFailures++;
+        }
+    }
+}
+
+static void testFloats() {
+    check("fa3f800001", "1.0000001", "1.0000001");
+    check("fa7f7fffff", "3.4028235e38", "3.4028235e38");
+    check("fa00000001", "1.0e-45", "1.0e-45");
+    check("fa3dcccccd", "0.1", "0.1");
+    check("fb3fb999999999999a", "0.1", "0.1");
+    check("fb400921fb54442d18", "3.141592653589793", "3.141592653589793");
+    check("fb3ff0000000000001", "1.0000000000000002", "1.0000000000000002");
+    check("fb7fefffffffffffff", "1.7976931348623157e308", "1.7976931348623157e308");
+    check("fb0000000000000001", "5.0e-324", "5.0e-324");
+    check("fb7e37e43c8800759c", "1.0e300", "1.0e300");
+    check("fbc010666666666666", "-4.1", "-4.1");
+    check("fb430c6bf526340000", "1000000000000000.0", "1000000000000000.0");
+    check("fa47c35000", "100000.0", "100000.0");
+    check("f93e00", "1.5", "1.5");
+    check("f98000", "-0.0", "-0.0");
+    check("f97e00", "null", "NaN");
+    check("f9fc00", "null", "-Infinity");
+}
+
+// Every printed float has to read back as the very same value
+static void testRoundTrip() {
+    srand(7);
+    unsigned int failures = 0;
+    for (int i = 0; i < 200000; i++) {
+        uint64_t bits = ((uint64_t)rand() << 62) ^ ((uint64_t)rand() << 31) ^ (uint64_t)rand();
+        bool isDouble = i % 2 == 0;
+        unsigned char bytes[9];
+        bytes[0] = isDouble ? 0xFB : 0xFA;
+        unsigned int size = isDouble ? 8 : 4;
+        for (unsigned int b = 0; b < size; b++) {
+            bytes[1 + b] = bits >> (8 * (size - 1 - b));
+        }
+        double value = isDouble ? cborBitsToDouble(bits) : cborBitsToFloat((uint32_t)bits);
+        if (isnan(value) || isinf(value)) {
+            continue;
+        }
+
+        CborInput input(bytes, size + 1);
+        StringPrint out;
+        CborJsonTranscoder transcoder(out);
+        transcoder.transcode(input);
+        double back = isDouble ? strtod(out.text.c_str(), NULL) : strtof(out.text.c_str(), NULL);
+        if (memcmp(&back, &value, sizeof value) != 0 && failures++ < 5) {
+            printf("%.17g printed as %s\n", value, out.text.c_str());
+        }
+    }
+    CHECK(failures == 0);
+}
+
+static void testKeys() {
+    check("a10102", "{\"1\":2}", "{1:2}");
+    check("a1c10102", "{\"1\":2}", "{1(1):2}");
+    check("a1c1c10102", "{\"1\":2}", "{1(1(1)):2}");
+    check("a2c1016161c10203", "{\"1\":\"a\",\"2\":3}", "{1(1):\"a\",1(2):3}");
+    check("a1f93e0001", "{\"1.5\":1}", "{1.5:1}");
+    check("a1f601", "{\"null\":1}", "{null:1}");
+    check("a141ff01", "{\"_w\":1}", "{h'ff':1}");
+    check("a1810102", NULL, "{[1]:2}");
+    check("a1a1010202", NULL, "{{1:2}:2}");
+    check("a1c1810102", NULL, "{1([1]):2}");
+    check("a1016162", "{\"1\":\"b\"}", "{1:\"b\"}");
+}
+
+static void testItems() {
+    check("a26161016162820203", "{\"a\":1,\"b\":[2,3]}", "{\"a\":1,\"b\":[2,3]}");
+    check("1bffffffffffffffff", "18446744073709551615", "18446744073709551615");
+    check("3bffffffffffffffff", "-18446744073709551616", "-18446744073709551616");
+    check("3903e7", "-1000", "-1000");
+    check("62225c", "\"\\\"\\\\\"", "\"\\\"\\\\\"");
+    check("4401020304", "\"AQIDBA\"", "h'01020304'");
+    check("f7", "null", "undefined");
+    check("f0", "null", "simple(16)");
+    check("c11a514b67b0", "1363896240", "1(1363896240)");
+    check("8301", NULL, NULL);
+}
+
+int main() {
+    testFloats();
+    testRoundTrip();
+    testKeys();
+    testItems();
+    return testResult();
+}
@@ -0,0 +1,86 @@
+#include "test.h"
+#include "BinaryLayout.h"
+
+struct Reading {
+    uint8_t status;
+    bool alarm;
+    uint16_t light;
+    float temperature;
+    uint32_t uptime;
+    int8_t trend;
+    int64_t total;
+};
+
+typedef BinaryLayout<Reading,
+    BINARY_BITS(Reading, status, 3),
+    BINARY_BITS(Reading, alarm, 1),
+    BINARY_BITS(Reading, light, 10),
+    BINARY_FIELD(Reading, temperature),
+    BINARY_FIELD_LE(Reading, uptime),
+    BINARY_BITS(Reading, trend, 5),
+    BINARY_FIELD(Reading, total)> ReadingLayout;
+
+static_assert(ReadingLayout::size == 2 + 4 + 4 + 1 + 8, "bit fields share bytes, whole fields start on one");
+
+static const Reading reading = {5, true, 1000, 21.5f, 0x01020304, -3, -2};
+
+// The same bytes as writing every field by hand
+static void testEncode() {
+    BinaryPayload layout(32);
+    CHECK(layout.add((uint8_t)0xEE));
+    CHECK(ReadingLayout::encode(layout, reading));
+
+    BinaryPayload manual(32);
+    CHECK(manual.add((uint8_t)0xEE));
+    CHECK(manual.addBits(reading.status, 3));
+    CHECK(manual.addBits(reading.alarm, 1));
+    CHECK(manual.addBits(reading.light, 10));
+    CHECK(manual.add(reading.temperature));
+    const uint8_t uptime[] = {0x04, 0x03, 0x02, 0x01};
+    CHECK(manual.addArray(uptime, 4));
+    CHECK(manual.addBits((uint32_t)reading.trend, 5));
+    CHECK(manual.add(reading.total));
+
+    CHECK(layout.getSize() == 1 + ReadingLayout::size);
+    CHECK(manual.getSize() == layout.getSize());
+    CHECK_BYTES(manual.getBytes(), layout.getBytes(), manual.getSize());
+}
+
+static void testDecode() {
+    BinaryPayload payload(2 * ReadingLayout::size);
+    CHECK(ReadingLayout::encode(payload, reading));
+    CHECK(ReadingLayout::encode(payload, reading));
+
+    BinaryReader reader(payload.getBytes(), payload.getSize());
+    for (int i = 0; i < 2; i++) {
+        Reading decoded;
+        memset(&decoded, 0xFF, sizeof decoded);
+        CHECK(ReadingLayout::decode(reader, decoded));
+        CHECK(decoded.status == 5 && decoded.alarm && decoded.light == 1000);
+        CHECK(decoded.temperature == 21.5f && decoded.uptime == 0x01020304);
+        CHECK(decoded.trend == -3 && decoded.total == -2);
+    }
+    Reading rest;
+    CHECK(!ReadingLayout::decode(reader, rest));
+}
+
+// A record either fits whole or isn't written at all
+static void testCapacity() {
+    BinaryPayload payload(ReadingLayout::size + 2);
+    CHECK(payload.add((uint16_t)1));
+    CHECK(ReadingLayout::encode(payload, reading));
+    CHECK(!ReadingLayout::encode(payload, reading));
+    CHECK(payload.getSize() == ReadingLayout::size + 2);
+
+    BinaryReader reader(payload.getBytes(), ReadingLayout::size - 1);
+    Reading decoded;
+    CHECK(!ReadingLayout::decode(reader, decoded));
+    CHECK(reader.getRemaining() == ReadingLayout::size - 1);
+}
+
+int main() {
+    testEncode();
+    testDecode();
+    testCapacity();
+    return testResult();
+}
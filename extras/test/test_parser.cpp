@@ -0,0 +1,80 @@
+#include "test.h"
+#include "CborParser.h"
+
+static void testEquals() {
+    CborStringView view;
+    view.data = "temp\0x";
+    view.length = 6;
+    CHECK(!view.equals("temp"));
+    CHECK(!view.equals("temp\0x"));
+
+    view.length = 4;
+    CHECK(view.equals("temp"));
+    CHECK(!view.equals("te"));
+    CHECK(!view.equals("temperature"));
+
+    // A shorter str must not be read past its end
+    char shorter[2] = {'t', 0};
+    CHECK(!view.equals(shorter));
+}
+
+static void testIntRange() {
+    const unsigned char message[] = {
+        0x1B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,   // INT64_MAX
+        0x1B, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // INT64_MAX + 1
+        0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,   // INT64_MIN
+        0x3B, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // INT64_MIN - 1
+        0x3B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};  // -2^64
+    CborInput input((void *)message, sizeof message);
+    CborParser parser(input);
+
+    CHECK(parser.next() && parser.fitsInt() && parser.asInt() == INT64_MAX);
+    CHECK(parser.next() && !parser.fitsInt() && parser.asInt() == INT64_MAX);
+    CHECK(parser.asFloat() == 9223372036854775808.0);
+    CHECK(parser.next() && parser.fitsInt() && parser.asInt() == INT64_MIN);
+    CHECK(parser.next() && !parser.fitsInt() && parser.asInt() == INT64_MIN);
+    CHECK(parser.next() && !parser.fitsInt() && parser.isNegative());
+    CHECK(parser.asFloat() == -18446744073709551616.0);
+    CHECK(!parser.next() && parser.type() == CBOR_TYPE_END);
+}
+
+// Counts that can't fit in what's left of the input are rejected up front
+static void testCounts() {
+    const unsigned char hugeMap[] = {0xBB, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00};
+    CborInput mapInput((void *)hugeMap, sizeof hugeMap);
+    CborParser mapParser(mapInput);
+    CHECK(!mapParser.next() && mapParser.type() == CBOR_TYPE_ERROR);
+    CHECK(!mapParser.skip());
+
+    const unsigned char hugeArray[] = {0x9B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00};
+    CborInput arrayInput((void *)hugeArray, sizeof hugeArray);
+    CborParser arrayParser(arrayInput);
+    CHECK(!arrayParser.next() && arrayParser.type() == CBOR_TYPE_ERROR);
+
+    // One map entry needs two bytes
+    const unsigned char shortMap[] = {0xA2, 0x01, 0x02, 0x03};
+    CborInput shortInput((void *)shortMap, sizeof shortMap);
+    CborParser shortParser(shortInput);
+    CHECK(!shortParser.next() && shortParser.type() == CBOR_TYPE_ERROR);
+
+    const unsigned char exact[] = {0x82, 0xA1, 0x01, 0x02, 0x83, 0x01, 0x02, 0x03, 0x04};
+    CborInput exactInput((void *)exact, sizeof exact);
+    CborParser exactParser(exactInput);
+    CHECK(exactParser.next() && exactParser.asCount() == 2);
+    CHECK(exactParser.skip());
+    CHECK(exactParser.next() && exactParser.asInt() == 4);
+
+    // Fits on its own, but not with its nested items
+    const unsigned char nested[] = {0x81, 0x83, 0x01, 0x02};
+    CborInput nestedInput((void *)nested, sizeof nested);
+    CborParser nestedParser(nestedInput);
+    CHECK(nestedParser.next() && !nestedParser.skip());
+    CHECK(nestedParser.type() == CBOR_TYPE_ERROR);
+}
+
+int main() {
+    testEquals();
+    testIntRange();
+    testCounts();
+    return testResult();
+}
@@ -0,0 +1,153 @@
+#include "test.h"
+#include "CborPayload.h"
+#include "CborParser.h"
+
+#include <string>
+
+// Collects what's written, and counts the calls
+class Sink : public Print {
+public:
+    std::string bytes;
+    unsigned int writes = 0;
+
+    virtual size_t write(uint8_t value) {
+        writes++;
+        bytes.push_back((char)value);
+        return 1;
+    }
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        writes++;
+        bytes.append((const char *)buffer, size);
+        return size;
+    }
+};
+
+// getBytes(), encodedSize() and writeTo() all have to agree
+static void checkEncodings(CborPayload &payload, unsigned int assets, bool meta) {
+    unsigned int size = payload.encodedSize();
+    CHECK(payload.getSize() == size);
+    Sink sink;
+    CHECK(payload.writeTo(sink) == size);
+    CHECK(sink.bytes.size() == size);
+    CHECK(sink.writes <= 3);
+    unsigned char *bytes = payload.getBytes();
+    CHECK_BYTES(sink.bytes.data(), bytes, size);
+
+    CborInput input(bytes, size);
+    CborParser parser(input);
+    unsigned int items = 1;
+    if (meta) {
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_TAG && parser.asTag() == 120);
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_ARRAY);
+        items = parser.asCount();
+    }
+    CHECK(parser.next() && parser.type() == CBOR_TYPE_MAP && parser.asCount() == assets);
+    for (unsigned int i = 0; i < assets; i++) {
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_STRING);
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_INTEGER && parser.asInt() == (int64_t)i);
+    }
+    for (unsigned int i = 1; i < items; i++) {
+        CHECK(parser.next() && parser.skip());
+    }
+    CHECK(!parser.next() && parser.type() == CBOR_TYPE_END);
+}
+
+static void fill(CborPayload &payload, char (*names)[8], unsigned int assets) {
+    for (unsigned int i = 0; i < assets; i++) {
+        snprintf(names[i], 8, "a%u", i);
+        CHECK(payload.set(names[i], i));
+    }
+}
+
+// From 24 assets on the map header takes 2 bytes, from 256 on 3
+static void testManyAssets() {
+    static char names[300][8];
+    const unsigned int counts[] = {1, 23, 24, 30, 255, 256, 300};
+    for (unsigned int c = 0; c < sizeof counts / sizeof counts[0]; c++) {
+        CborPayload payload(4096);
+        fill(payload, names, counts[c]);
+        checkEncodings(payload, counts[c], false);
+
+        payload.setTimestamp(1700000000000ULL);
+        checkEncodings(payload, counts[c], true);
+        payload.setLocation(GeoLocation(51.05, 3.72, 12));
+        checkEncodings(payload, counts[c], true);
+    }
+
+    CborPayload payload(256);
+    fill(payload, names, 30);
+    const unsigned char expected[] = {0xB8, 30, 0x62, 'a', '0', 0x00};
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+}
+
+static void testContains() {
+    CborPayload payload;
+    CHECK(!payload.contains("a"));
+    payload.set((char *)"a", 1);
+    CborBuilder nested = payload.setObject((char *)"b", 1);
+    CHECK(nested.set((char *)"c", 2));
+    CHECK(nested.end());
+    CHECK(payload.set((char *)"s618190", (char *)"a"));
+    CHECK(payload.contains("a") && payload.contains("b") && payload.contains("s618190"));
+    CHECK(!payload.contains("c"));          // nested, not an asset
+    CHECK(!payload.contains("s31597"));     // same FNV-1a hash as s618190
+    CHECK(!payload.contains("ab"));
+
+    // Only once it's complete
+    CborBuilder open = payload.setArray((char *)"d", 1);
+    CHECK(!payload.contains("d"));
+    CHECK(open.add(1) && open.end());
+    CHECK(payload.contains("d"));
+}
+
+// A full buffer leaves no room for meta data, so it's refused, and the other
+// way around assets stop early enough for it: getBytes() is always complete
+static void testFullWithMeta() {
+    static char names[64][8];
+    for (unsigned int i = 0; i < 64; i++) {
+        snprintf(names[i], 8, "a%u", i);
+    }
+
+    CborPayload full(64);
+    unsigned int assets = 0;
+    while (full.set(names[assets], assets)) {
+        assets++;
+    }
+    unsigned int size = full.getSize();
+    CHECK(!full.setTimestamp(1700000000000ULL));
+    CHECK(!full.setLocation(GeoLocation(51.05, 3.72, 12)));
+    CHECK(full.getSize() == size);
+    checkEncodings(full, assets, false);
+
+    for (int meta = 0; meta < 3; meta++) {
+        CborPayload payload(64);
+        if (meta != 1) CHECK(payload.setTimestamp(1700000000000ULL));
+        if (meta != 0) CHECK(payload.setLocation(GeoLocation(51.05, 3.72, 12)));
+        unsigned int count = 0;
+        while (payload.set(names[count], count)) {
+            count++;
+        }
+        CHECK(count > 0 && count < assets);
+        CHECK(payload.getSize() <= 64);
+        checkEncodings(payload, count, true);
+    }
+
+    // Room for a timestamp, but not a location as well
+    CborPayload some(64);
+    CHECK(some.setTimestamp(1700000000000ULL));
+    unsigned int count = 0;
+    while (some.set(names[count], count)) {
+        count++;
+    }
+    GeoLocation location(51.05, 3.72, 12);
+    CHECK(!some.setLocation(location));
+    CHECK(some.setTimestamp(1));
+    checkEncodings(some, count, true);
+}
+
+int main() {
+    testManyAssets();
+    testContains();
+    testFullWithMeta();
+    return testResult();
+}
@@ -0,0 +1,70 @@
+#include "test.h"
+#include "PayloadPool.h"
+
+#include <utility>
+
+static void testExhaustion() {
+    PayloadPool<CborPayload, 2, 32> pool;
+    CHECK(pool.getCount() == 2 && pool.getInUse() == 0);
+
+    auto first = pool.acquire();
+    auto second = pool.acquire();
+    CHECK(first && second && &*first != &*second);
+    auto third = pool.acquire();
+    CHECK(!third && !third.isValid());
+    CHECK(pool.getInUse() == 2 && pool.getHighWater() == 2);
+    CHECK(pool.getAcquired() == 2 && pool.getFailures() == 1);
+
+    // A payload comes back reset
+    first->set((char *)"t", 1);
+    CHECK(first->getSize() > 0);
+    CborPayload *payload = &*first;
+    first.release();
+    CHECK(!first && pool.getInUse() == 1);
+    first.release();
+    CHECK(pool.getInUse() == 1);
+
+    auto again = pool.acquire();
+    CHECK(again && &*again == payload && again->getSize() == 0);
+    CHECK(!pool.acquire());
+    CHECK(pool.getFailures() == 2 && pool.getAcquired() == 3 && pool.getHighWater() == 2);
+}
+
+// Moving hands the payload over, and the last owner gives it back
+static void testMove() {
+    PayloadPool<CborPayload, 2, 32> pool;
+    {
+        auto lease = pool.acquire();
+        CborPayload *payload = &*lease;
+        auto moved = std::move(lease);
+        CHECK(!lease && moved && &*moved == payload);
+        CHECK(pool.getInUse() == 1);
+
+        // Assigning over a lease gives its own payload back first
+        auto other = pool.acquire();
+        CHECK(pool.getInUse() == 2);
+        other = std::move(moved);
+        CHECK(!moved && &*other == payload && pool.getInUse() == 1);
+        other = std::move(other);
+        CHECK(other && pool.getInUse() == 1);
+    }
+    CHECK(pool.getInUse() == 0 && pool.getHighWater() == 2);
+}
+
+// Pooled payloads write into the pool's buffers, and stop at their capacity
+static void testBinary() {
+    PayloadPool<BinaryPayload, 1, 4> pool;
+    auto lease = pool.acquire();
+    CHECK(lease->add((uint16_t)1) && lease->add((uint16_t)2));
+    CHECK(!lease->add((uint8_t)3));
+    CHECK(lease->getSize() == 4);
+    const unsigned char expected[] = {0x00, 0x01, 0x00, 0x02};
+    CHECK_BYTES(expected, lease->getBytes(), sizeof expected);
+}
+
+int main() {
+    testExhaustion();
+    testMove();
+    testBinary();
+    return testResult();
+}
@@ -0,0 +1,96 @@
+#include "test.h"
+#include "BinaryPayload.h"
+#include "CborPayload.h"
+#include "CborBatch.h"
+#include "Quantization.h"
+
+static void testValidity() {
+    CHECK(Quantization(0.1f).isValid());
+    CHECK(Quantization(1, 0, 2).isValid());
+    CHECK(Quantization(1, 0, 32).isValid());
+    CHECK(!Quantization(1, 0, 1).isValid());
+    CHECK(!Quantization(1, 0, 0).isValid());
+    CHECK(!Quantization(1, 0, 33).isValid());
+    CHECK(!Quantization(0).isValid());
+
+    const Quantization oneBit(1, 0, 1);
+    CborPayload cbor;
+    CHECK(!cbor.set((char *)"t", 1.0f, oneBit));
+    CHECK(cbor.getSize() == 0);
+    BinaryPayload binary(8);
+    CHECK(!binary.addQuantized(1.0f, oneBit));
+    CHECK(binary.getSize() == 0);
+}
+
+// The scale and offset go along with the value, so it decodes on its own
+static void testCborCarriesScale() {
+    CborPayload payload;
+    CHECK(payload.set((char *)"a", 21.37f, Quantization(0.1f)));
+    CHECK(payload.set((char *)"b", 1013.4f, Quantization(1, 1000, 8)));
+    CHECK(payload.set((char *)"c", 0.21f, Quantization(0.01f, 0.05f)));
+    CHECK(payload.set((char *)"d", 1.3f, Quantization(0.25f)));
+    CHECK(payload.set((char *)"e", 1e6f, Quantization(0.5f, 0, 8)));
+    CHECK(payload.set((char *)"f", -0.7f, Quantization(0.1f)));
+    const unsigned char expected[] = {
+        0xA6,
+        0x61, 'a', 0xFA, 0x41, 0xAB, 0x33, 0x33,         // 21.4, smaller than 4([-1, 214])
+        0x61, 'b', 0x19, 0x03, 0xF5,                     // 1013
+        0x61, 'c', 0xC4, 0x82, 0x21, 0x15,               // 4([-2, 21])
+        0x61, 'd', 0xFA, 0x3F, 0xA0, 0x00, 0x00,         // 1.25
+        0x61, 'e', 0xFA, 0x42, 0x7E, 0x00, 0x00,         // clamped to 127 steps of 0.5
+        0x61, 'f', 0xC4, 0x82, 0x20, 0x26};              // 4([-1, -7])
+    CHECK(payload.getSize() == sizeof expected);
+    CHECK_BYTES(expected, payload.getBytes(), sizeof expected);
+}
+
+// Whichever way a quantized value is written, it decodes to the same step
+static void testRoundTrip() {
+    const float values[] = {21.37f, -0.7f, 0.0f, 1.5f, 123456.7f, -99999.9f, 2.3f};
+    const Quantization quantizations[] = {
+        Quantization(0.1f, 0, 32), Quantization(0.01f, 0.05f), Quantization(100, -2000), Quantization(0.001f, 0, 32)};
+    for (const Quantization &quantization : quantizations) {
+        CborPayload payload;
+        char names[7][2];
+        for (int i = 0; i < 7; i++) {
+            names[i][0] = 'a' + i;
+            names[i][1] = 0;
+            CHECK(payload.set(names[i], values[i], quantization));
+        }
+        const unsigned char *messages[] = {payload.getBytes()};
+        const unsigned int lengths[] = {payload.getSize()};
+        CborBatchDecoder decoder;
+        CborBatch batch(8);
+        CHECK(decoder.decode(messages, lengths, 1, batch) == 1);
+        CHECK(batch.size == 7);
+        for (int i = 0; i < 7; i++) {
+            CHECK(batch.types[i] == CBOR_VALUE_FLOAT || batch.types[i] == CBOR_VALUE_INTEGER);
+            CHECK(quantization.quantize((float)batch.numbers[i]) == quantization.quantize(values[i]));
+        }
+    }
+
+    // Exact as a double, not just as a float
+    const unsigned char message[] = {0xA1, 0x61, 'a', 0xC4, 0x82, 0x20, 0x19, 0x08, 0x5A};
+    const unsigned char *messages[] = {message};
+    const unsigned int lengths[] = {sizeof message};
+    CborBatchDecoder decoder;
+    CborBatch batch(1);
+    CHECK(decoder.decode(messages, lengths, 1, batch) == 1);
+    CHECK(batch.types[0] == CBOR_VALUE_FLOAT && batch.numbers[0] == 213.8);
+}
+
+static void testDecimal() {
+    Quantization tenths(0.1f);
+    CHECK(tenths.isDecimal() && tenths.exponent == -1 && tenths.offsetSteps == 0);
+    Quantization hundreds(100, -2000);
+    CHECK(hundreds.isDecimal() && hundreds.exponent == 2 && hundreds.offsetSteps == -20);
+    CHECK(!Quantization(0.1f, 0.05f).isDecimal());
+    CHECK(!Quantization(0.2f).isDecimal());
+}
+
+int main() {
+    testValidity();
+    testCborCarriesScale();
+    testDecimal();
+    testRoundTrip();
+    return testResult();
+}
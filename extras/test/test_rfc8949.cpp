@@ -0,0 +1,192 @@
+// Examples from RFC 8949 Appendix A, through CborReader and CborParser
+#include "test.h"
+#include "CborDecoder.h"
+#include "CborParser.h"
+
+#include <math.h>
+#include <string>
+#include <vector>
+
+static std::vector<unsigned char> fromHex(const char *hex) {
+    std::vector<unsigned char> bytes;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned int byte;
+        sscanf(hex, "%2x", &byte);
+        bytes.push_back(byte);
+    }
+    return bytes;
+}
+
+static bool sameDouble(double a, double b) {
+    return (isnan(a) && isnan(b)) || (a == b && signbit(a) == signbit(b));
+}
+
+class FloatListener : public CborListener {
+public:
+    std::vector<double> floats;
+    std::string log;
+
+    virtual void OnInteger(int32_t value) { log += "int " + std::to_string(value); }
+    virtual void OnBytes(unsigned char *data, unsigned int size) { log += "bytes " + std::to_string(size); delete[] data; }
+    virtual void OnString(String &str) { log += std::string("string ") + str.c_str(); }
+    virtual void OnArray(unsigned int size) { log += "array " + std::to_string(size) + ","; }
+    virtual void OnMap(unsigned int size) { log += "map " + std::to_string(size) + ","; }
+    virtual void OnTag(uint32_t tag) { log += "tag " + std::to_string(tag) + ","; }
+    virtual void OnSpecial(uint32_t code) { log += "special " + std::to_string(code); }
+    virtual void OnError(const char *error) { log += std::string("error ") + error; }
+    virtual void OnFloat(double value) { floats.push_back(value); }
+    virtual void OnExtraInteger(uint64_t value, int sign) { log += (sign < 0 ? "-extra " : "extra ") + std::to_string(value); }
+    virtual void OnExtraTag(uint64_t tag) { log += "extratag " + std::to_string(tag); }
+};
+
+// Doesn't override OnFloat, like listeners written before it existed
+class LegacyListener : public FloatListener {
+public:
+    virtual void OnFloat(double value) { CborListener::OnFloat(value); }
+    virtual void OnExtraSpecial(uint64_t bits) { log += "extraspecial " + std::to_string(bits); }
+};
+
+struct FloatExample {
+    const char *hex;
+    double value;
+};
+
+static const FloatExample floatExamples[] = {
+    {"f90000", 0.0},
+    {"f98000", -0.0},
+    {"f93c00", 1.0},
+    {"fb3ff199999999999a", 1.1},
+    {"f93e00", 1.5},
+    {"f97bff", 65504.0},
+    {"fa47c35000", 100000.0},
+    {"fa7f7fffff", 3.4028234663852886e+38},
+    {"fb7e37e43c8800759c", 1.0e+300},
+    {"f90001", 5.960464477539063e-8},
+    {"f90400", 0.00006103515625},
+    {"f9c400", -4.0},
+    {"fbc010666666666666", -4.1},
+    {"f97c00", INFINITY},
+    {"f97e00", NAN},
+    {"f9fc00", -INFINITY},
+    {"fa7f800000", INFINITY},
+    {"fa7fc00000", NAN},
+    {"faff800000", -INFINITY},
+    {"fb7ff0000000000000", INFINITY},
+    {"fb7ff8000000000000", NAN},
+    {"fbfff0000000000000", -INFINITY},
+};
+
+static void testFloats() {
+    for (unsigned int i = 0; i < sizeof floatExamples / sizeof floatExamples[0]; i++) {
+        std::vector<unsigned char> bytes = fromHex(floatExamples[i].hex);
+
+        FloatListener listener;
+        CborInput input(&bytes[0], bytes.size());
+        CborReader reader(input, listener);
+        reader.Run();
+        if (!(listener.floats.size() == 1 && sameDouble(listener.floats[0], floatExamples[i].value) && listener.log.empty())) {
+            printf("CborReader: %s\n", floatExamples[i].hex);
+            testFailures++;
+        }
+
+        CborInput parserInput(&bytes[0], bytes.size());
+        CborParser parser(parserInput);
+        if (!(parser.next() && parser.type() == CBOR_TYPE_FLOAT && sameDouble(parser.asFloat(), floatExamples[i].value))) {
+            printf("CborParser: %s\n", floatExamples[i].hex);
+            testFailures++;
+        }
+    }
+}
+
+// Without an OnFloat of their own, listeners get the raw bits as before
+static void testLegacyFloats() {
+    std::vector<unsigned char> bytes = fromHex("83f93e00fa47c35000fb3ff199999999999a");
+    LegacyListener listener;
+    CborInput input(&bytes[0], bytes.size());
+    CborReader reader(input, listener);
+    reader.Run();
+    CHECK(listener.floats.empty());
+    CHECK(listener.log == "array 3,special 15872special 1203982336extraspecial 4607632778762754458");
+}
+
+struct Example {
+    const char *hex;
+    const char *events;
+};
+
+static const Example examples[] = {
+    {"00", "int 0"},
+    {"01", "int 1"},
+    {"0a", "int 10"},
+    {"17", "int 23"},
+    {"1818", "int 24"},
+    {"1819", "int 25"},
+    {"1864", "int 100"},
+    {"1903e8", "int 1000"},
+    {"1a000f4240", "int 1000000"},
+    {"1b000000e8d4a51000", "extra 1000000000000"},
+    {"1bffffffffffffffff", "extra 18446744073709551615"},
+    {"3bffffffffffffffff", "-extra 18446744073709551615"},
+    {"20", "int -1"},
+    {"29", "int -10"},
+    {"3863", "int -100"},
+    {"3903e7", "int -1000"},
+    {"f4", "special 20"},
+    {"f5", "special 21"},
+    {"f6", "special 22"},
+    {"f7", "special 23"},
+    {"f0", "special 16"},
+    {"f8ff", "special 255"},
+    {"c074323031332d30332d32315432303a30343a30305a", "tag 0,string 2013-03-21T20:04:00Z"},
+    {"c11a514b67b0", "tag 1,int 1363896240"},
+    {"d74401020304", "tag 23,bytes 4"},
+    {"d818456449455446", "tag 24,bytes 5"},
+    {"40", "bytes 0"},
+    {"4401020304", "bytes 4"},
+    {"60", "string "},
+    {"6161", "string a"},
+    {"6449455446", "string IETF"},
+    {"62225c", "string \"\\"},
+    {"62c3bc", "string \xc3\xbc"},
+    {"80", "array 0,"},
+    {"83010203", "array 3,int 1int 2int 3"},
+    {"8301820203820405", "array 3,int 1array 2,int 2int 3array 2,int 4int 5"},
+    {"98190102030405060708090a0b0c0d0e0f101112131415161718181819",
+        "array 25,int 1int 2int 3int 4int 5int 6int 7int 8int 9int 10int 11int 12int 13"
+        "int 14int 15int 16int 17int 18int 19int 20int 21int 22int 23int 24int 25"},
+    {"a0", "map 0,"},
+    {"a201020304", "map 2,int 1int 2int 3int 4"},
+    {"a26161016162820203", "map 2,string aint 1string barray 2,int 2int 3"},
+    {"826161a161626163", "array 2,string amap 1,string bstring c"},
+    {"a56161614161626142616361436164614461656145",
+        "map 5,string astring Astring bstring Bstring cstring Cstring dstring Dstring estring E"},
+};
+
+static void testExamples() {
+    for (unsigned int i = 0; i < sizeof examples / sizeof examples[0]; i++) {
+        std::vector<unsigned char> bytes = fromHex(examples[i].hex);
+        FloatListener listener;
+        CborInput input(&bytes[0], bytes.size());
+        CborReader reader(input, listener);
+        reader.Run();
+        if (listener.log != examples[i].events) {
+            printf("%s: got \"%s\"\n", examples[i].hex, listener.log.c_str());
+            testFailures++;
+        }
+
+        // The parser has to get through all of it in one skip()
+        CborInput parserInput(&bytes[0], bytes.size());
+        CborParser parser(parserInput);
+        if (!(parser.next() && parser.skip() && !parser.next() && parser.type() == CBOR_TYPE_END)) {
+            printf("CborParser: %s\n", examples[i].hex);
+            testFailures++;
+        }
+    }
+}
+
+int main() {
+    testFloats();
+    testLegacyFloats();
+    testExamples();
+    return testResult();
+}
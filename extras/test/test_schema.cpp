@@ -0,0 +1,133 @@
+// Built without the Arduino stub, so it also checks that CborSchema.h
+// doesn't pull in the Arduino core
+#include "test.h"
+#include "CborSchema.h"
+
+#ifdef ARDUINO_H_
+#error "CborSchema.h included Arduino.h"
+#endif
+
+struct Command {
+    int speed;
+    float angle;
+    bool enabled;
+    char mode[8];
+};
+
+static const CborField<Command> commandFields[] = {
+    CborField<Command>("speed", &Command::speed),
+    CborField<Command>("angle", &Command::angle),
+    CborField<Command>("enabled", &Command::enabled),
+    CborField<Command>("mode", &Command::mode),
+};
+static const CborSchema<Command> commandSchema(commandFields);
+
+struct Setting {
+    unsigned char level;
+    short offset;
+    double gain;
+};
+
+// Fields without char arrays are built at compile time
+static constexpr CborField<Setting> settingFields[] = {
+    CborField<Setting>("level", &Setting::level),
+    CborField<Setting>("offset", &Setting::offset),
+    CborField<Setting>("gain", &Setting::gain),
+};
+static_assert(settingFields[0].hash == cborFieldHash("level"), "hashed at compile time");
+static_assert(settingFields[2].member.asDouble == &Setting::gain, "member kept as its own type");
+static const CborSchema<Setting> settingSchema(settingFields);
+
+static void testDecode() {
+    const unsigned char message[] = {
+        0xA4,
+        0x65, 's', 'p', 'e', 'e', 'd', 0x18, 100,
+        0x65, 'a', 'n', 'g', 'l', 'e', 0xF9, 0x3E, 0x00,
+        0x67, 'e', 'n', 'a', 'b', 'l', 'e', 'd', 0xF5,
+        0x64, 'm', 'o', 'd', 'e', 0x64, 'f', 'a', 's', 't'};
+    Command command;
+    CborInput input((void *)message, sizeof message);
+    CborSchemaResult result = commandSchema.decode(input, command);
+    CHECK(result.isValid());
+    CHECK(command.speed == 100 && command.angle == 1.5f && command.enabled && strcmp(command.mode, "fast") == 0);
+}
+
+// Keys only match in full, embedded zeros included
+static void testKeys() {
+    const unsigned char message[] = {
+        0xA3,
+        0x67, 's', 'p', 'e', 'e', 'd', 0x00, 'x', 0x01,
+        0x62, 's', 'p', 0x02,
+        0x65, 's', 'p', 'e', 'e', 'd', 0x03};
+    Command command;
+    CborInput input((void *)message, sizeof message);
+    CborSchemaResult result = commandSchema.decode(input, command);
+    CHECK(result.error == NULL && result.found == 1 && command.speed == 3);
+    CHECK(result.isMissing(1) && !result.isMistyped(1));
+}
+
+static void testConstexpr() {
+    const unsigned char message[] = {
+        0xA3,
+        0x65, 'l', 'e', 'v', 'e', 'l', 0x18, 200,
+        0x66, 'o', 'f', 'f', 's', 'e', 't', 0x39, 0x01, 0x00,
+        0x64, 'g', 'a', 'i', 'n', 0xFA, 0x3F, 0xC0, 0x00, 0x00};
+    Setting setting;
+    CborInput input((void *)message, sizeof message);
+    CborSchemaResult result = settingSchema.decode(input, setting);
+    CHECK(result.isValid());
+    CHECK(setting.level == 200 && setting.offset == -257 && setting.gain == 1.5);
+}
+
+// A value of the wrong type leaves the member alone, and the rest still decodes
+static void testWrongType() {
+    const unsigned char message[] = {
+        0xA4,
+        0x65, 's', 'p', 'e', 'e', 'd', 0x63, 'f', 'a', 's',
+        0x65, 'a', 'n', 'g', 'l', 'e', 0xF5,
+        0x67, 'e', 'n', 'a', 'b', 'l', 'e', 'd', 0x01,
+        0x64, 'm', 'o', 'd', 'e', 0x82, 0x01, 0x02};
+    Command command = {7, 2.5f, false, "slow"};
+    CborInput input((void *)message, sizeof message);
+    CborSchemaResult result = commandSchema.decode(input, command);
+    CHECK(result.error == NULL && !result.isValid());
+    CHECK(result.found == 0 && result.mistyped == 15);
+    CHECK(result.isMistyped(0) && result.isMistyped(3));
+    CHECK(command.speed == 7 && command.angle == 2.5f && !command.enabled && strcmp(command.mode, "slow") == 0);
+}
+
+// Integers that don't fit the member, and strings that don't fit with their terminator
+static void testOutOfRange() {
+    const unsigned char message[] = {
+        0xA4,
+        0x65, 'l', 'e', 'v', 'e', 'l', 0x19, 0x01, 0x00,
+        0x66, 'o', 'f', 'f', 's', 'e', 't', 0x39, 0x80, 0x00,
+        0x64, 'g', 'a', 'i', 'n', 0x3B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0x65, 'l', 'e', 'v', 'e', 'l', 0x20};
+    Setting setting = {1, 2, 3};
+    CborInput input((void *)message, sizeof message);
+    CborSchemaResult result = settingSchema.decode(input, setting);
+    CHECK(result.error == NULL);
+    CHECK(result.isMistyped(0) && result.isMistyped(1) && !result.isMistyped(2));
+    CHECK(setting.level == 1 && setting.offset == 2 && setting.gain == -18446744073709551616.0);
+
+    const unsigned char longMode[] = {
+        0xA2,
+        0x64, 'm', 'o', 'd', 'e', 0x68, 'e', 'i', 'g', 'h', 't', '!', '!', '!',
+        0x65, 's', 'p', 'e', 'e', 'd', 0x1A, 0x80, 0x00, 0x00, 0x00};
+    Command command = {7, 2.5f, false, "slow"};
+    CborInput modeInput((void *)longMode, sizeof longMode);
+    result = commandSchema.decode(modeInput, command);
+    CHECK(result.error == NULL && result.found == 0);
+    CHECK(result.isMistyped(0) && result.isMistyped(3));
+    CHECK(command.speed == 7 && strcmp(command.mode, "slow") == 0);
+}
+
+int main() {
+    testDecode();
+    testKeys();
+    testConstexpr();
+    testWrongType();
+    testOutOfRange();
+    return testResult();
+}
@@ -0,0 +1,133 @@
+#include "test.h"
+#include "CborSeriesPayload.h"
+#include "CborParser.h"
+
+#include <stdlib.h>
+#include <vector>
+#include <string>
+
+struct Sample {
+    uint64_t timestamp;
+    float value;
+};
+
+struct ExpectedAsset {
+    std::string name;
+    std::vector<Sample> samples;
+};
+
+// Decodes the payload and compares it to what was added, asset by asset
+static void checkSeries(CborSeriesPayload &series, uint64_t base, std::vector<ExpectedAsset> &expected) {
+    CborInput input(series.getBytes(), series.getSize());
+    CborParser parser(input);
+    CHECK(parser.next() && parser.type() == CBOR_TYPE_ARRAY && parser.asCount() == 2);
+    CHECK(parser.next() && parser.type() == CBOR_TYPE_INTEGER && parser.asUnsigned() == base);
+    CHECK(parser.next() && parser.type() == CBOR_TYPE_MAP && parser.asCount() == expected.size());
+
+    for (unsigned int a = 0; a < expected.size(); a++) {
+        std::vector<Sample> &samples = expected[a].samples;
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_STRING);
+        CHECK(parser.asStringView().equals(expected[a].name.c_str()));
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_ARRAY && parser.asCount() == 2);
+
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_ARRAY && parser.asCount() == samples.size());
+        uint64_t timestamp = base;
+        for (unsigned int i = 0; i < samples.size(); i++) {
+            CHECK(parser.next() && parser.type() == CBOR_TYPE_INTEGER);
+            timestamp += parser.asUnsigned();
+            CHECK(timestamp == samples[i].timestamp);
+        }
+
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_TAG);
+        CHECK(parser.asTag() == (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? 85 : 81));
+        CHECK(parser.next() && parser.type() == CBOR_TYPE_BYTES);
+        CborStringView values = parser.asStringView();
+        CHECK(values.length == samples.size() * 4);
+        for (unsigned int i = 0; i < samples.size() && i * 4 < values.length; i++) {
+            float value;
+            memcpy(&value, values.data + i * 4, 4);
+            CHECK(value == samples[i].value);
+        }
+    }
+    CHECK(!parser.next());
+    CHECK(input.getRemaining() == 0);
+}
+
+static void testKnownEncoding() {
+    CborSeriesPayload series(64, 8, 2);
+    CHECK(series.getSize() == 0);
+    CHECK(series.add("t", 1000, 1.5f));
+    CHECK(series.add("t", 1010, 2.0f));
+    const unsigned char expected[] = {
+        0x82, 0x19, 0x03, 0xE8, 0xA1, 0x61, 't', 0x82,
+        0x82, 0x00, 0x0A,
+        0xD8, __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? 85 : 81, 0x48};
+    CHECK(series.getSize() == sizeof expected + 8);
+    CHECK_BYTES(expected, series.getBytes(), sizeof expected);
+}
+
+// Interleaved assets, sample counts and sizes crossing every CBOR header
+// boundary (24 samples, 24 and 256 byte strings), and a timestamp base that
+// grows the outer header
+static void testRandomInterleaving() {
+    const char *names[] = {"temperature", "a", "a-very-long-asset-name-that-needs-two-header-bytes", "pressure"};
+    srand(3);
+    for (int round = 0; round < 50; round++) {
+        CborSeriesPayload series(4096, 400, 4);
+        std::vector<ExpectedAsset> expected;
+        uint64_t base = round % 2 ? 1700000000000ULL + rand() : rand() % 30;
+        uint64_t timestamp = base;
+        int samples = rand() % 300 + 1;
+        for (int i = 0; i < samples; i++) {
+            const char *name = names[rand() % 4];
+            float value = (float)rand() / 7;
+            unsigned int a = 0;
+            while (a < expected.size() && expected[a].name != name) a++;
+            if (a == expected.size()) {
+                ExpectedAsset asset;
+                asset.name = name;
+                expected.push_back(asset);
+            }
+            Sample sample = {timestamp, value};
+            CHECK(series.add(name, timestamp, value));
+            expected[a].samples.push_back(sample);
+            timestamp += rand() % 3 == 0 ? rand() % 70000 : rand() % 20;
+        }
+        CHECK(series.getSampleCount() == (unsigned int)samples);
+        checkSeries(series, base, expected);
+    }
+}
+
+static void testLimits() {
+    CborSeriesPayload series(40, 100, 1);
+    CHECK(series.add("x", 5, 1));
+    CHECK(!series.add("y", 5, 1));          // only 1 asset
+    CHECK(!series.add("x", 4, 1));          // going back in time
+    CHECK(!series.add("x", 5 + 0x100000000ULL, 1));
+    unsigned int added = 1;
+    while (!series.isFull()) {
+        CHECK(series.add("x", 5 + added, added));
+        added++;
+    }
+    // isFull() is conservative: the sample after it may or may not fit, but never overflows
+    while (series.add("x", 1000000, 1)) {
+        added++;
+    }
+    CHECK(series.getSize() <= 40);
+    CHECK(series.getSampleCount() == added);
+
+    CborSeriesPayload counted(1024, 3, 2);
+    CHECK(counted.add("a", 1, 1) && counted.add("b", 1, 1) && counted.add("a", 2, 1));
+    CHECK(counted.isFull());
+    CHECK(!counted.add("a", 3, 1));
+
+    series.reset();
+    CHECK(series.getSize() == 0 && series.getBytes() == NULL);
+}
+
+int main() {
+    testKnownEncoding();
+    testRandomInterleaving();
+    testLimits();
+    return testResult();
+}
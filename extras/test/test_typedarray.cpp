@@ -0,0 +1,52 @@
+#include "test.h"
+#include "CborEncoder.h"
+#include "CborParser.h"
+
+static const bool littleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+// One tag, then all of data as a single byte string
+template<typename T> static void checkTypedArray(uint32_t bigEndianTag, bool hasByteOrder) {
+    T data[5];
+    for (unsigned int i = 0; i < 5; i++) {
+        data[i] = (T)(i * 37 + 1);
+    }
+    CborStaticOutput output(128);
+    CborWriter writer(output);
+    writer.writeTypedArray(data, 5);
+
+    CborInput input(output.getData(), output.getSize());
+    CborParser parser(input);
+    uint32_t tag = hasByteOrder && littleEndian ? bigEndianTag + 4 : bigEndianTag;
+    CHECK(parser.next() && parser.type() == CBOR_TYPE_TAG && parser.asTag() == tag);
+    CHECK(parser.next() && parser.type() == CBOR_TYPE_BYTES);
+    CborStringView bytes = parser.asStringView();
+    CHECK(bytes.length == sizeof data);
+    CHECK_BYTES(data, bytes.data, sizeof data);
+    CHECK(!parser.next() && parser.type() == CBOR_TYPE_END);
+}
+
+int main() {
+    checkTypedArray<uint8_t>(64, false);
+    checkTypedArray<int8_t>(72, false);
+    checkTypedArray<uint16_t>(65, true);
+    checkTypedArray<int16_t>(73, true);
+    checkTypedArray<uint32_t>(66, true);
+    checkTypedArray<int32_t>(74, true);
+    checkTypedArray<uint64_t>(67, true);
+    checkTypedArray<int64_t>(75, true);
+    checkTypedArray<float>(81, true);
+    checkTypedArray<double>(82, true);
+
+    // Empty arrays are still tagged, and an empty byte string fits even at the start
+    CborStaticOutput empty(4);
+    empty.putBytes(NULL, 0);
+    CHECK(!empty.hasOverflowed() && empty.getSize() == 0);
+
+    CborStaticOutput output(8);
+    CborWriter writer(output);
+    writer.writeTypedArray((const float *)NULL, 0);
+    const unsigned char expected[] = {0xD8, littleEndian ? 85 : 81, 0x40};
+    CHECK(output.getSize() == sizeof expected && !output.hasOverflowed());
+    CHECK_BYTES(expected, output.getData(), sizeof expected);
+    return testResult();
+}
@@ -0,0 +1,91 @@
+#include "test.h"
+#include "BinaryPayload.h"
+#include "BinaryReader.h"
+
+#include <stdlib.h>
+
+static void testKnownEncodings() {
+    BinaryPayload payload(16);
+    payload.addVarint(300);
+    const unsigned char varint300[] = {0xAC, 0x02};
+    CHECK(payload.getSize() == 2);
+    CHECK_BYTES(varint300, payload.getBytes(), 2);
+
+    payload.reset();
+    payload.addZigzag(-1);
+    payload.addZigzag(1);
+    payload.addZigzag(-64);
+    const unsigned char zigzag[] = {0x01, 0x02, 0x7F};
+    CHECK(payload.getSize() == 3);
+    CHECK_BYTES(zigzag, payload.getBytes(), 3);
+}
+
+static void testEdgeValues() {
+    const int64_t values[] = {
+        0, 1, -1, 63, -64, 64, -65, 127, 128, 8191, -8192, 8192, 16383, 16384,
+        (int64_t)1 << 40, INT64_MAX, INT64_MIN};
+    const unsigned int count = sizeof values / sizeof values[0];
+
+    BinaryPayload payload(count * 20);
+    for (unsigned int i = 0; i < count; i++) {
+        CHECK(payload.addZigzag(values[i]));
+        CHECK(payload.addVarint((uint64_t)values[i]));
+    }
+
+    BinaryReader reader(payload.getBytes(), payload.getSize());
+    for (unsigned int i = 0; i < count; i++) {
+        int64_t zigzag;
+        uint64_t varint;
+        CHECK(reader.readZigzag(zigzag) && zigzag == values[i]);
+        CHECK(reader.readVarint(varint) && varint == (uint64_t)values[i]);
+    }
+    CHECK(reader.getRemaining() == 0);
+}
+
+static void testCapacity() {
+    // UINT64_MAX takes 10 bytes, and nothing is added if it doesn't fit
+    BinaryPayload payload(11);
+    CHECK(payload.addVarint(UINT64_MAX));
+    CHECK(payload.getSize() == 10);
+    CHECK(!payload.addVarint(300));
+    CHECK(payload.getSize() == 10);
+    CHECK(payload.addVarint(127));
+    CHECK(payload.getSize() == 11);
+}
+
+static void testTruncatedInput() {
+    const unsigned char truncated[] = {0x80, 0x80};
+    BinaryReader reader(truncated, sizeof truncated);
+    uint64_t value;
+    CHECK(!reader.readVarint(value));
+
+    // More than 10 bytes can't be a 64 bit value
+    const unsigned char tooLong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+    BinaryReader longReader(tooLong, sizeof tooLong);
+    CHECK(!longReader.readVarint(value));
+}
+
+static void testRandomRoundTrips() {
+    srand(5);
+    for (int i = 0; i < 100000; i++) {
+        int64_t value = ((int64_t)rand() << 33) ^ rand();
+        value >>= rand() % 63;
+        if (rand() & 1) {
+            value = -value;
+        }
+        BinaryPayload payload(16);
+        CHECK(payload.addZigzag(value));
+        BinaryReader reader(payload.getBytes(), payload.getSize());
+        int64_t decoded;
+        CHECK(reader.readZigzag(decoded) && decoded == value);
+    }
+}
+
+int main() {
+    testKnownEncodings();
+    testEdgeValues();
+    testCapacity();
+    testTruncatedInput();
+    testRandomRoundTrips();
+    return testResult();
+}
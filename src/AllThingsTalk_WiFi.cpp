@@ -26,8 +26,10 @@
 #include "AllThingsTalk_WiFi.h"
 #include "Arduino.h"
 #include "CborPayload.h"
+#include "CborSeriesPayload.h"
 #include "GeoLocation.h"
 #include "BinaryPayload.h"
+#include "PayloadCompression.h"
 #include "PubSubClient.h"
 #include <ArduinoJson.h>
 
@@ -268,6 +270,78 @@ bool Device::wifiSignalReporting(bool state, int time) {
     return true;
 }
 
+// Used to check if payloadCompression is enabled
+bool Device::payloadCompression() {
+    return compressionEnabled;
+}
+
+// Used to set payloadCompression on/off
+bool Device::payloadCompression(bool state) {
+    compressionEnabled = state;
+    return true;
+}
+
+// Used to set payloadCompression on/off and the size (bytes) from which payloads get compressed
+bool Device::payloadCompression(bool state, unsigned int threshold) {
+    compressionEnabled = state;
+    compressionThreshold = threshold;
+    return true;
+}
+
+// Used to check if sendBatching is enabled
+bool Device::sendBatching() {
+    return batchingEnabled;
+}
+
+// Used to set sendBatching on/off, turning it off sends what's batched right away
+bool Device::sendBatching(bool state) {
+    if (!state && batchingEnabled) {
+        // A batch that can't be sent now is retried by loop()
+        flushBatch();
+    }
+    batchingEnabled = state;
+    return true;
+}
+
+// Used to set sendBatching on/off, the longest time (milliseconds) a value may wait and the largest batch (bytes).
+// False, changing nothing, if a batch of the old size couldn't be sent first.
+bool Device::sendBatching(bool state, unsigned long window, unsigned int maxSize) {
+    if (batchPayload != NULL && maxSize != batchMaxSize) {
+        if (!flushBatch()) {
+            return false;
+        }
+        delete batchPayload;
+        batchPayload = NULL;
+    }
+    batchWindow = window;
+    batchMaxSize = maxSize;
+    return sendBatching(state);
+}
+
+// Used to only send values of asset that changed by more than deadband
+bool Device::changeFilter(const char *asset, float deadband) {
+    return changeFilters.add(asset, deadband);
+}
+
+// Used to set all Report by Exception parameters of asset (times in milliseconds, 0 is off)
+bool Device::changeFilter(const char *asset, float deadband, float relativeDeadband, unsigned long minInterval, unsigned long heartbeat) {
+    return changeFilters.add(asset, deadband, relativeDeadband, minInterval, heartbeat);
+}
+
+// Used to send every value of asset again
+bool Device::removeChangeFilter(const char *asset) {
+    return changeFilters.remove(asset);
+}
+
+// Used to check how many values of filtered assets were sent and suppressed
+ChangeFilterStats Device::changeFilterStats() {
+    return changeFilters.getStats();
+}
+
+ChangeFilterStats Device::changeFilterStats(const char *asset) {
+    return changeFilters.getStats(asset);
+}
+
 // Used to check if connectionLed is enabled or disabled
 bool Device::connectionLed() {
     if (ledEnabled) {
@@ -423,6 +497,7 @@ void Device::loop() {
     mqtt.loop();
     reportWiFiSignal();
     maintainAllThingsTalk();
+    maintainBatch();
     yield();
 }
 
@@ -1138,14 +1213,175 @@ void Device::mqttCallback(char* p_topic, byte* p_payload, unsigned int p_length)
 }
 #endif
 
+// Compresses bytes into compressionBuffer, if compression is enabled and it makes the message smaller.
+// Returns the compressed size, or 0 if the message should be sent as it is.
+unsigned int Device::compressState(const unsigned char *bytes, unsigned int size) {
+    // The compressed payload also has to make up for the longer topic
+    unsigned int suffixLength = strlen(COMPRESSED_TOPIC_SUFFIX);
+    if (!compressionEnabled || size < compressionThreshold || size <= suffixLength) {
+        return 0;
+    }
+    if (compressionBuffer == NULL) {
+        compressionBufferSize = mqtt.getBufferSize();
+        compressionBuffer = new unsigned char[compressionBufferSize];
+    }
+    unsigned int capacity = size - suffixLength - 1;
+    if (capacity > compressionBufferSize) {
+        capacity = compressionBufferSize;
+    }
+    unsigned int compressedSize = compressPayload(bytes, size, compressionBuffer, capacity);
+    if (compressedSize > 0) {
+        debugVerbose("Compressed from", ' ');
+        debugVerbose(size, ' ');
+        debugVerbose("to", ' ');
+        debugVerbose(compressedSize, ' ');
+        debugVerbose("bytes");
+    }
+    return compressedSize;
+}
+
+// Ends a publish started with beginPublish(). A message that was cut short can't be
+// taken back, so the connection is dropped instead; loop() reconnects.
+bool Device::endPublish(size_t written, unsigned int size) {
+    mqtt.endPublish();
+    if (written == size) {
+        return true;
+    }
+    debug("Message was cut short while publishing:", ' ');
+    debug(written, ' ');
+    debug("of", ' ');
+    debug(size, ' ');
+    debug("bytes sent. Disconnecting.");
+    mqtt.disconnect();
+    return false;
+}
+
+// Publishes bytes to topic, which has room for topicSize characters
+bool Device::publishBytes(char *topic, unsigned int topicSize, const unsigned char *bytes, unsigned int size) {
+    unsigned int compressedSize = compressState(bytes, size);
+    if (compressedSize > 0) {
+        strncat(topic, COMPRESSED_TOPIC_SUFFIX, topicSize - strlen(topic) - 1);
+        bytes = compressionBuffer;
+        size = compressedSize;
+    }
+    if (!mqtt.beginPublish(topic, size, false)) {
+        return false;
+    }
+    return endPublish(mqtt.write(bytes, size), size);
+}
+
+// Publishes to the device state topic (followed by topicSuffix), compressed if enabled and it makes the message smaller.
+// Uncompressed messages are streamed, so they don't have to fit the MQTT buffer either.
+bool Device::publishState(unsigned char *bytes, unsigned int size, const char *topicSuffix) {
+    char topic[128];
+    snprintf(topic, sizeof topic, "%s%s%s%s", "device/", deviceCreds->getDeviceId(), "/state", topicSuffix);
+    return publishBytes(topic, sizeof topic, bytes, size);
+}
+
+// Streams the payload in chunks, so it doesn't have to fit the MQTT buffer.
+// Compression needs the whole message at once, so it goes through getBytes().
+bool Device::publishState(Payload &payload, const char *topicSuffix) {
+    unsigned int size = payload.encodedSize();
+    if (compressionEnabled && size >= compressionThreshold) {
+        return publishState(payload.getBytes(), payload.getSize(), topicSuffix);
+    }
+
+    char topic[128];
+    snprintf(topic, sizeof topic, "%s%s%s%s", "device/", deviceCreds->getDeviceId(), "/state", topicSuffix);
+    if (!mqtt.beginPublish(topic, size, false)) {
+        return false;
+    }
+    return endPublish(payload.writeTo(mqtt), size);
+}
+
 // Send data as CBOR
 bool Device::send(CborPayload &payload) {
     if (WiFi.status() == WL_CONNECTED) {
         if (mqtt.connected()) {
+            if (!flushBatchFirst()) {
+                return false;
+            }
+            if (!payload.usesDictionaryKeys()) {
+                if (!publishState(payload)) {
+                    debug("Publishing the message failed");
+                    return false;
+                }
+                debug("> Message Published to AllThingsTalk (CBOR)");
+                return true;
+            }
+            // The receiving side needs the dictionary before it can resolve the keys
+            CborAssetDictionary *dictionary = payload.getDictionary();
+            if ((dictionary != sentDictionary || dictionary->getCount() != sentDictionaryCount) && !send(*dictionary)) {
+                return false;
+            }
+            if (!publishState(payload, KEYED_TOPIC_SUFFIX)) {
+                debug("Publishing the message failed");
+                return false;
+            }
+            debug("> Message Published to AllThingsTalk (CBOR, dictionary keys)");
+            return true;
+        } else {
+            debug("Can't publish message because you're not connected to AllThingsTalk");
+            return false;
+        }
+    } else {
+        debug("Can't publish message because you're not connected to WiFi");
+        return false;
+    }
+}
+
+// Send the asset dictionary, retained so it also reaches whoever subscribes later
+bool Device::send(CborAssetDictionary &dictionary) {
+    if (WiFi.status() == WL_CONNECTED) {
+        if (mqtt.connected()) {
+            if (!flushBatchFirst()) {
+                return false;
+            }
             char topic[128];
-            snprintf(topic, sizeof topic, "%s%s%s", "device/", deviceCreds->getDeviceId(), "/state");
-            mqtt.publish(topic, payload.getBytes(), payload.getSize());
-            debug("> Message Published to AllThingsTalk (CBOR)");
+            snprintf(topic, sizeof topic, "%s%s%s%s", "device/", deviceCreds->getDeviceId(), "/state", DICTIONARY_TOPIC_SUFFIX);
+            // Streamed in small chunks, so it needs no buffer of its own
+            unsigned int size = dictionary.getEncodedSize();
+            bool published = false;
+            if (mqtt.beginPublish(topic, size, true)) {
+                CborPrintOutput output(mqtt);
+                CborWriter writer(output);
+                dictionary.write(writer);
+                published = endPublish(output.flush(), size);
+            }
+            if (!published) {
+                debug("Publishing the asset dictionary failed");
+                return false;
+            }
+            sentDictionary = &dictionary;
+            sentDictionaryCount = dictionary.getCount();
+            debug("> Asset Dictionary Published to AllThingsTalk");
+            debugVerbose("Assets:", ' ');
+            debugVerbose(sentDictionaryCount);
+            return true;
+        } else {
+            debug("Can't publish message because you're not connected to AllThingsTalk");
+            return false;
+        }
+    } else {
+        debug("Can't publish message because you're not connected to WiFi");
+        return false;
+    }
+}
+
+// Send data as CBOR time series
+bool Device::send(CborSeriesPayload &payload) {
+    if (WiFi.status() == WL_CONNECTED) {
+        if (mqtt.connected()) {
+            if (!flushBatchFirst()) {
+                return false;
+            }
+            if (!publishState(payload, SERIES_TOPIC_SUFFIX)) {
+                debug("Publishing the message failed");
+                return false;
+            }
+            debug("> Message Published to AllThingsTalk (CBOR Series)");
+            debugVerbose("Samples:", ' ');
+            debugVerbose(payload.getSampleCount());
             return true;
         } else {
             debug("Can't publish message because you're not connected to AllThingsTalk");
@@ -1161,9 +1397,13 @@ bool Device::send(CborPayload &payload) {
 bool Device::send(BinaryPayload &payload) {
     if (WiFi.status() == WL_CONNECTED) {
         if (mqtt.connected()) {
-            char topic[128];
-            snprintf(topic, sizeof topic, "%s%s%s", "device/", deviceCreds->getDeviceId(), "/state");
-            mqtt.publish(topic, payload.getBytes(), payload.getSize());
+            if (!flushBatchFirst()) {
+                return false;
+            }
+            if (!publishState(payload)) {
+                debug("Publishing the message failed");
+                return false;
+            }
             debug("> Message Published to AllThingsTalk (Binary Payload)");
             return true;
         } else {
@@ -1176,16 +1416,157 @@ bool Device::send(BinaryPayload &payload) {
     }
 }
 
+// Numbers and booleans are compared against the deadbands, text only has to change.
+// A value only counts as sent once changeFilterSent() is called for it.
+template<typename T> static bool changeFilterAllows(ChangeFilter &filter, const char *asset, T value) {
+    return filter.check(asset, (double)value, millis());
+}
+
+static bool changeFilterAllows(ChangeFilter &filter, const char *asset, const char *value) {
+    return filter.check(asset, value, millis());
+}
+
+static bool changeFilterAllows(ChangeFilter &filter, const char *asset, char *value) {
+    return filter.check(asset, value, millis());
+}
+
+static bool changeFilterAllows(ChangeFilter &filter, const char *asset, String value) {
+    return filter.check(asset, value.c_str(), millis());
+}
+
+template<typename T> static void changeFilterSent(ChangeFilter &filter, const char *asset, T value) {
+    filter.commit(asset, (double)value, millis());
+}
+
+static void changeFilterSent(ChangeFilter &filter, const char *asset, const char *value) {
+    filter.commit(asset, value, millis());
+}
+
+static void changeFilterSent(ChangeFilter &filter, const char *asset, char *value) {
+    filter.commit(asset, value, millis());
+}
+
+static void changeFilterSent(ChangeFilter &filter, const char *asset, String value) {
+    filter.commit(asset, value.c_str(), millis());
+}
+
+// Adds a value to the batch, sending the batch first if the asset is already in it
+// or the value doesn't fit. False if the value doesn't even fit an empty batch,
+// or the batch had to be sent first and that failed; batchAssetCount tells which.
+template<typename T> bool Device::batchAsset(char *asset, T value) {
+    if (batchPayload == NULL) {
+        batchPayload = new CborPayload(batchMaxSize);
+    }
+
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (const char *c = asset; *c; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    // The hash only rules names out, the batch itself has the names to compare
+    for (int i = 0; i < batchAssetCount; i++) {
+        if (batchAssets[i] == hash && batchPayload->contains(asset)) {
+            if (!flushBatch()) {
+                return false;
+            }
+            break;
+        }
+    }
+    if (batchAssetCount == maximumBatchAssets && !flushBatch()) {
+        return false;
+    }
+
+    if (!batchPayload->set(asset, value)) {
+        if (batchAssetCount == 0 || !flushBatch()) {
+            return false;
+        }
+        if (!batchPayload->set(asset, value)) {
+            return false;
+        }
+    }
+    if (batchAssetCount == 0) {
+        batchStart = millis();
+    }
+    batchAssets[batchAssetCount++] = hash;
+    debugVerbose("Batched value of asset", ' ');
+    debugVerbose(asset);
+    return true;
+}
+
+// Sends the batch once its first value has waited for batchWindow
+void Device::maintainBatch() {
+    if (batchAssetCount > 0 && mqtt.connected() && millis() - batchStart >= batchWindow) {
+        if (!flushBatch()) {
+            // Tried again after another window instead of on every loop
+            batchStart = millis();
+        }
+    }
+}
+
+// True once nothing is waiting anymore. A batch that couldn't be sent is kept, to be tried again.
+bool Device::flushBatch() {
+    if (batchAssetCount == 0) {
+        return true;
+    }
+    if (!mqtt.connected()) {
+        return false;
+    }
+    if (!publishState(*batchPayload)) {
+        debugVerbose("Batch couldn't be sent, keeping it. Assets:", ' ');
+        debugVerbose(batchAssetCount);
+        return false;
+    }
+    debug("> Message Published to AllThingsTalk (Batch)");
+    debugVerbose("Assets:", ' ');
+    debugVerbose(batchAssetCount);
+    batchPayload->reset();
+    batchAssetCount = 0;
+    return true;
+}
+
+// Payloads sent explicitly go out after the values batched before them
+bool Device::flushBatchFirst() {
+    if (!flushBatch()) {
+        debug("Can't publish message because the batch before it couldn't be sent");
+        return false;
+    }
+    return true;
+}
+
 template<typename T> bool Device::send(char *asset, T payload) {
     if (WiFi.status() == WL_CONNECTED) {
         if (mqtt.connected()) {
+            if (!changeFilterAllows(changeFilters, asset, payload)) {
+                changeFilters.suppress(asset);
+                debugVerbose("Value didn't change enough to be sent. Asset:", ' ');
+                debugVerbose(asset);
+                return true;
+            }
+            if (batchingEnabled) {
+                // A batched value is kept until it's sent, so it counts as sent already
+                if (batchAsset(asset, payload)) {
+                    changeFilterSent(changeFilters, asset, payload);
+                    return true;
+                }
+                // Sent on its own it would overtake the values still waiting
+                if (batchAssetCount > 0) {
+                    debug("Can't publish message because the batch before it couldn't be sent");
+                    return false;
+                }
+            } else if (!flushBatchFirst()) {
+                // Left over from when batching was turned off
+                return false;
+            }
             char topic[128];
             snprintf(topic, sizeof topic, "%s%s%s%s%s", "device/", deviceCreds->getDeviceId(), "/asset/", asset, "/state");
             DynamicJsonDocument doc(256);
             char JSONmessageBuffer[256];
             doc["value"] = payload;
             serializeJson(doc, JSONmessageBuffer);
-            mqtt.publish(topic, JSONmessageBuffer, false);
+            if (!mqtt.publish(topic, JSONmessageBuffer, false)) {
+                debug("Publishing the message failed");
+                return false;
+            }
+            changeFilterSent(changeFilters, asset, payload);
             debug("> Message Published to AllThingsTalk (JSON)");
             debugVerbose("Asset:", ' ');
             debugVerbose(asset, ',');
@@ -1213,6 +1594,50 @@ template bool Device::send(char *asset, long payload);
 template bool Device::send(char *asset, float payload);
 template bool Device::send(char *asset, double payload);
 
+// Send data as JSON, CBOR or Binary Payload, whichever is smallest
+bool Device::send(AutoPayload &payload) {
+    if (WiFi.status() == WL_CONNECTED) {
+        if (mqtt.connected()) {
+            if (!flushBatchFirst()) {
+                return false;
+            }
+            PayloadFormat format = payload.select(deviceCreds->getDeviceId());
+            if (format != PAYLOAD_FORMAT_JSON) {
+                if (!publishState(payload)) {
+                    debug("Publishing the message failed");
+                    return false;
+                }
+                payload.recordPublished(deviceCreds->getDeviceId());
+                debug(format == PAYLOAD_FORMAT_CBOR ? "> Message Published to AllThingsTalk (Auto, CBOR)" : "> Message Published to AllThingsTalk (Auto, Binary Payload)");
+                return true;
+            }
+            // Published directly, as the payload's stats count these messages,
+            // so they mustn't be held back by change filters or batching
+            bool published = true;
+            char topic[128];
+            char JSONmessageBuffer[256];
+            for (unsigned int i = 0; i < payload.getCount(); i++) {
+                snprintf(topic, sizeof topic, "%s%s%s%s%s", "device/", deviceCreds->getDeviceId(), "/asset/", payload.getAsset(i), "/state");
+                if (payload.writeJson(i, JSONmessageBuffer, sizeof JSONmessageBuffer) == 0 || !mqtt.publish(topic, JSONmessageBuffer, false)) {
+                    debug("Publishing failed for asset", ' ');
+                    debug(payload.getAsset(i));
+                    published = false;
+                } else {
+                    payload.recordPublished(deviceCreds->getDeviceId(), i);
+                }
+            }
+            debug("> Message Published to AllThingsTalk (Auto, JSON)");
+            return published;
+        } else {
+            debug("Can't publish message because you're not connected to AllThingsTalk");
+            return false;
+        }
+    } else {
+        debug("Can't publish message because you're not connected to WiFi");
+        return false;
+    }
+}
+
 #ifndef SUPPORTS
 Device::Device(WifiCredentials &wifiCreds, DeviceConfig &deviceCreds) {
     #error "Currently, ESP8266 (all ESP8266-based devices) and MKR1010 are supported. Open up an issue on GitHub if you'd like us to support your device."
@@ -29,7 +29,11 @@
 #include "WifiCredentials.h"
 #include "DeviceConfig.h"
 #include "CborPayload.h"
+#include "CborSeriesPayload.h"
 #include "BinaryPayload.h"
+#include "AutoPayload.h"
+#include "ChangeFilter.h"
+#include "SampleAggregator.h"
 
 class ActuationCallback {
 public:
@@ -66,7 +70,10 @@ public:
     
     // Sending Data
     bool send(CborPayload &payload);
+    bool send(CborSeriesPayload &payload);
+    bool send(CborAssetDictionary &dictionary);
     bool send(BinaryPayload &payload);
+    bool send(AutoPayload &payload);
     template<typename T> bool send(char *asset, T payload);
     
     // Connection
@@ -95,6 +102,23 @@ public:
     bool wifiSignalReporting(bool state, int time);
     String wifiSignal();
 
+    // Payload Compression
+    bool payloadCompression(); // Use to check if Payload Compression is enabled
+    bool payloadCompression(bool);
+    bool payloadCompression(bool state, unsigned int threshold);
+
+    // Send Batching
+    bool sendBatching(); // Use to check if Send Batching is enabled
+    bool sendBatching(bool);
+    bool sendBatching(bool state, unsigned long window, unsigned int maxSize);
+
+    // Report by Exception (only for send(asset, value))
+    bool changeFilter(const char *asset, float deadband);
+    bool changeFilter(const char *asset, float deadband, float relativeDeadband, unsigned long minInterval, unsigned long heartbeat);
+    bool removeChangeFilter(const char *asset);
+    ChangeFilterStats changeFilterStats();
+    ChangeFilterStats changeFilterStats(const char *asset);
+
     // Callbacks (Receiving Data)
     // These will return 
     bool setActuationCallback(String asset, void (*actuationCallback)(bool payload));
@@ -132,6 +156,17 @@ private:
     void reportWiFiSignal();
     void showMaskedCredentials();
 
+    // Sending Data
+    unsigned int compressState(const unsigned char *bytes, unsigned int size);
+    bool endPublish(size_t written, unsigned int size);
+    bool publishBytes(char *topic, unsigned int topicSize, const unsigned char *bytes, unsigned int size);
+    bool publishState(unsigned char *bytes, unsigned int size, const char *topicSuffix = "");
+    bool publishState(Payload &payload, const char *topicSuffix = "");
+    template<typename T> bool batchAsset(char *asset, T value);
+    void maintainBatch();
+    bool flushBatch();
+    bool flushBatchFirst();
+
     // Actuations / Callbacks
     #ifdef ESP8266
     void mqttCallback(char* p_topic, byte* p_payload, unsigned int p_length);
@@ -193,6 +228,29 @@ private:
     int rssiReportInterval  = 300;                 // Default interval (seconds) for WiFi Signal Reporting
     unsigned long rssiPrevTime;                    // Remembers last time WiFi Signal was reported
 
+    // Payload Compression Parameters
+    bool compressionEnabled             = false;   // Default value for Payload Compression
+    unsigned int compressionThreshold   = 128;     // Payloads smaller than this (bytes) are sent as they are
+    unsigned char *compressionBuffer    = NULL;    // Allocated on first use, as big as the MQTT buffer
+    unsigned int compressionBufferSize  = 0;
+
+    // Asset Dictionary Parameters
+    CborAssetDictionary *sentDictionary = NULL;    // Last dictionary published, sent again when another one is used
+    unsigned int sentDictionaryCount    = 0;       // Assets it had then, sent again when assets were added
+
+    // Send Batching Parameters
+    static const int maximumBatchAssets = 32;
+    bool batchingEnabled                = false;   // Default value for Send Batching
+    unsigned long batchWindow           = 1000;    // Longest time (milliseconds) a value waits in the batch
+    unsigned int batchMaxSize           = 256;     // Largest batch (bytes) before it's sent
+    CborPayload *batchPayload           = NULL;    // Allocated on first use, batchMaxSize big
+    unsigned long batchStart;                      // Remembers when the first value of the batch was added
+    uint32_t batchAssets[maximumBatchAssets];      // Name hashes of batched assets, to find repeats quickly
+    int batchAssetCount                 = 0;
+
+    // Report by Exception Parameters
+    ChangeFilter changeFilters;                    // Deadbands and last sent values of filtered assets
+
     // Debug parameters
     bool debugVerboseEnabled = false;
 
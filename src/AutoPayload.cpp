@@ -0,0 +1,294 @@
+#include <string.h>
+#include <stdint.h>
+#include "Arduino.h"
+#include <ArduinoJson.h>
+
+#include "AutoPayload.h"
+#include "BinaryPayload.h"
+
+AutoPayload::AutoPayload(unsigned int capacity, unsigned int maxAssets) {
+    this->capacity = capacity;
+    this->maxAssets = maxAssets;
+    buffer = new unsigned char[capacity];
+    values = new Value[maxAssets];
+    forgetFormats();
+}
+
+AutoPayload::~AutoPayload() {
+    delete[] buffer;
+    delete[] values;
+}
+
+void AutoPayload::reset() {
+    count = 0;
+    size = 0;
+}
+
+unsigned char *AutoPayload::getBytes() {
+    return buffer;
+}
+
+unsigned int AutoPayload::getSize() {
+    return size;
+}
+
+void AutoPayload::allowBinary(bool allowed) {
+    binaryAllowed = allowed;
+    forgetFormats();
+}
+
+void AutoPayload::forgetFormats() {
+    for (int i = 0; i < rememberedCount; i++) {
+        rememberedKeys[i] = 0;
+    }
+    rememberedNext = 0;
+}
+
+PayloadFormat AutoPayload::getFormat() {
+    return format;
+}
+
+AutoPayloadStats &AutoPayload::getStats() {
+    return stats;
+}
+
+unsigned int AutoPayload::getCount() {
+    return count;
+}
+
+const char *AutoPayload::getAsset(unsigned int index) {
+    return values[index].asset;
+}
+
+bool AutoPayload::add(const char *assetName, ValueType type) {
+    if (count >= maxAssets) {
+        return false;
+    }
+    values[count].asset = assetName;
+    values[count].type = type;
+    return true;
+}
+
+template<> bool AutoPayload::set(const char *assetName, bool value) {
+    if (!add(assetName, VALUE_BOOL)) return false;
+    values[count++].boolean = value;
+    return true;
+}
+
+template<> bool AutoPayload::set(const char *assetName, int value) {
+    if (!add(assetName, VALUE_INT)) return false;
+    values[count++].integer = value;
+    return true;
+}
+
+template<> bool AutoPayload::set(const char *assetName, long value) {
+    if (!add(assetName, VALUE_LONG)) return false;
+    values[count++].integer = value;
+    return true;
+}
+
+template<> bool AutoPayload::set(const char *assetName, float value) {
+    if (!add(assetName, VALUE_FLOAT)) return false;
+    values[count++].number = value;
+    return true;
+}
+
+template<> bool AutoPayload::set(const char *assetName, double value) {
+    if (!add(assetName, VALUE_DOUBLE)) return false;
+    values[count++].number = value;
+    return true;
+}
+
+template<> bool AutoPayload::set(const char *assetName, const char *value) {
+    if (!add(assetName, VALUE_STRING)) return false;
+    values[count++].string = value;
+    return true;
+}
+
+template<> bool AutoPayload::set(const char *assetName, char *value) {
+    return set<const char*>(assetName, value);
+}
+
+// FNV-1a over the asset names and value types
+uint32_t AutoPayload::getKey() {
+    uint32_t hash = 2166136261u;
+    for (unsigned int i = 0; i < count; i++) {
+        for (const char *c = values[i].asset; *c; c++) {
+            hash = (hash ^ (unsigned char)*c) * 16777619u;
+        }
+        hash = (hash ^ (0x80 | values[i].type)) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+// MQTT PUBLISH framing: fixed header, remaining length and topic length
+static unsigned int messageSize(unsigned int topicLength, unsigned int payloadSize) {
+    unsigned int remaining = 2 + topicLength + payloadSize;
+    unsigned int lengthBytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+    return 1 + lengthBytes + remaining;
+}
+
+template<typename T> void AutoPayload::setJson(T &doc, unsigned int index) {
+    Value &value = values[index];
+    switch (value.type) {
+        case VALUE_BOOL: doc["value"] = value.boolean; break;
+        case VALUE_INT: doc["value"] = (int)value.integer; break;
+        case VALUE_LONG: doc["value"] = value.integer; break;
+        case VALUE_FLOAT: doc["value"] = (float)value.number; break;
+        case VALUE_DOUBLE: doc["value"] = value.number; break;
+        case VALUE_STRING: doc["value"] = value.string; break;
+    }
+}
+
+size_t AutoPayload::writeJson(unsigned int index, char *out, size_t size) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> doc;
+    setJson(doc, index);
+    if (measureJson(doc) >= size) {
+        return 0;
+    }
+    return serializeJson(doc, out, size);
+}
+
+// Wire size of the JSON message of asset index
+unsigned int AutoPayload::jsonMessageSize(unsigned int index, unsigned int deviceIdLength) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> doc;
+    setJson(doc, index);
+    return messageSize(7 + deviceIdLength + 7 + strlen(values[index].asset) + 6, measureJson(doc));
+}
+
+// Wire size of the current values in format, or 0 if it can't be used
+unsigned int AutoPayload::measure(PayloadFormat format, unsigned int deviceIdLength) {
+    // "device/<id>/state" and "device/<id>/asset/<asset>/state"
+    unsigned int stateTopicLength = 7 + deviceIdLength + 6;
+    unsigned int total = 0;
+
+    if (format == PAYLOAD_FORMAT_JSON) {
+        for (unsigned int i = 0; i < count; i++) {
+            total += jsonMessageSize(i, deviceIdLength);
+        }
+        return total;
+    }
+
+    if (format == PAYLOAD_FORMAT_CBOR) {
+        CborCountingOutput output;
+        CborWriter writer(output);
+        writeCbor(writer);
+        total = output.getSize();
+    } else {
+        for (unsigned int i = 0; i < count; i++) {
+            switch (values[i].type) {
+                case VALUE_BOOL: total += sizeof(bool); break;
+                case VALUE_INT: total += sizeof(int); break;
+                case VALUE_LONG: total += sizeof(long); break;
+                case VALUE_FLOAT: total += sizeof(float); break;
+                case VALUE_DOUBLE: total += sizeof(double); break;
+                case VALUE_STRING: total += strlen(values[i].string); break;
+            }
+        }
+    }
+    if (total > capacity) {
+        return 0;
+    }
+    return messageSize(stateTopicLength, total);
+}
+
+void AutoPayload::writeCbor(CborWriter &writer) {
+    writer.writeMap(count);
+    for (unsigned int i = 0; i < count; i++) {
+        Value &value = values[i];
+        writer.writeString(value.asset, strlen(value.asset));
+        switch (value.type) {
+            case VALUE_BOOL: writer.writeSpecial(20 + (value.boolean ? 1 : 0)); break;
+            case VALUE_INT: writer.writeInt((int32_t)value.integer); break;
+            case VALUE_LONG: writer.writeInt((int64_t)value.integer); break;
+            case VALUE_FLOAT: writer.writeFloat(value.number); break;
+            case VALUE_DOUBLE: writer.writeDouble(value.number); break;
+            case VALUE_STRING: writer.writeString(value.string, strlen(value.string)); break;
+        }
+    }
+}
+
+// Writes CBOR or binary into the buffer; JSON is sent value by value
+bool AutoPayload::encode(PayloadFormat format) {
+    size = 0;
+    if (format == PAYLOAD_FORMAT_CBOR) {
+        // CborStaticOutput drops what doesn't fit, so check first
+        CborCountingOutput counter;
+        CborWriter countingWriter(counter);
+        writeCbor(countingWriter);
+        if (counter.getSize() > capacity) {
+            return false;
+        }
+        CborStaticOutput output(buffer, capacity);
+        CborWriter writer(output);
+        writeCbor(writer);
+        size = output.getSize();
+    } else if (format == PAYLOAD_FORMAT_BINARY) {
+        BinaryPayload binary(buffer, 0, capacity);
+        for (unsigned int i = 0; i < count; i++) {
+            Value &value = values[i];
+            bool added = false;
+            switch (value.type) {
+                case VALUE_BOOL: added = binary.add(value.boolean); break;
+                case VALUE_INT: added = binary.add((int)value.integer); break;
+                case VALUE_LONG: added = binary.add(value.integer); break;
+                case VALUE_FLOAT: added = binary.add((float)value.number); break;
+                case VALUE_DOUBLE: added = binary.add(value.number); break;
+                case VALUE_STRING: added = binary.add(value.string); break;
+            }
+            if (!added) {
+                return false;
+            }
+        }
+        size = binary.getSize();
+    }
+    return true;
+}
+
+void AutoPayload::recordPublished(const char *deviceId, unsigned int index) {
+    unsigned int deviceIdLength = strlen(deviceId);
+    stats.messages[format]++;
+    if (format == PAYLOAD_FORMAT_JSON) {
+        if (index < count) {
+            stats.bytes[format] += jsonMessageSize(index, deviceIdLength);
+        }
+    } else {
+        stats.bytes[format] += messageSize(7 + deviceIdLength + 6, size);
+    }
+}
+
+PayloadFormat AutoPayload::select(const char *deviceId) {
+    unsigned int deviceIdLength = strlen(deviceId);
+    uint32_t key = getKey();
+
+    for (int i = 0; i < rememberedCount; i++) {
+        if (rememberedKeys[i] == key && encode(rememberedFormats[i])) {
+            format = rememberedFormats[i];
+            stats.reused++;
+            return format;
+        }
+    }
+
+    unsigned int sizes[3];
+    format = PAYLOAD_FORMAT_JSON;
+    for (int candidate = PAYLOAD_FORMAT_JSON; candidate <= PAYLOAD_FORMAT_BINARY; candidate++) {
+        if (candidate == PAYLOAD_FORMAT_BINARY && !binaryAllowed) {
+            sizes[candidate] = 0;
+            continue;
+        }
+        sizes[candidate] = measure((PayloadFormat)candidate, deviceIdLength);
+        stats.measured[candidate] += sizes[candidate];
+        if (sizes[candidate] > 0 && sizes[candidate] < sizes[format]) {
+            format = (PayloadFormat)candidate;
+        }
+    }
+    if (!encode(format)) {
+        format = PAYLOAD_FORMAT_JSON;
+    }
+    stats.selections++;
+
+    rememberedKeys[rememberedNext] = key;
+    rememberedFormats[rememberedNext] = format;
+    rememberedNext = (rememberedNext + 1) % rememberedCount;
+    return format;
+}
@@ -0,0 +1,108 @@
+#ifndef AUTO_PAYLOAD_H_
+#define AUTO_PAYLOAD_H_
+
+#include "Payload.h"
+#include "CborEncoder.h"
+
+#include <string.h>
+#include <stdint.h>
+
+typedef enum {
+    PAYLOAD_FORMAT_JSON,
+    PAYLOAD_FORMAT_CBOR,
+    PAYLOAD_FORMAT_BINARY
+} PayloadFormat;
+
+// Sizes are what goes over the wire: payloads, topics and MQTT framing
+class AutoPayloadStats {
+public:
+    unsigned long messages[3] = {0, 0, 0};  // Published messages per format
+    unsigned long bytes[3] = {0, 0, 0};     // Bytes published per format
+    unsigned long measured[3] = {0, 0, 0};  // What each format would have cost, summed over selections
+    unsigned long selections = 0;           // Sends that measured all formats
+    unsigned long reused = 0;               // Sends that reused a remembered format
+};
+
+// Collects asset values and sends them as JSON messages, a CBOR payload or
+// a binary payload, whichever is smallest. The choice is remembered per set
+// of asset names and value types, so it's only measured the first time.
+// Binary is only considered after allowBinary(true), since it needs a
+// matching ABCL definition on the device. Asset names and string values
+// aren't copied, so they have to outlive the payload.
+class AutoPayload : public Payload {
+public:
+    AutoPayload(unsigned int capacity = 256, unsigned int maxAssets = 16);
+    ~AutoPayload();
+
+    template<typename T> bool set(const char *assetName, T value);
+    void allowBinary(bool allowed);
+
+    // Picks the format for the current values and encodes CBOR and binary
+    // into the payload; deviceId is needed to size the topics
+    PayloadFormat select(const char *deviceId);
+    // Counts a publish of the selected format in the stats, once it went
+    // through: the whole payload, or for JSON the message of asset index
+    void recordPublished(const char *deviceId, unsigned int index = 0);
+    void forgetFormats();
+    PayloadFormat getFormat();
+    AutoPayloadStats &getStats();
+
+    // JSON is sent as one {"value": ...} message per asset
+    unsigned int getCount();
+    const char *getAsset(unsigned int index);
+    // Returns the length written to out, or 0 if it doesn't fit
+    size_t writeJson(unsigned int index, char *out, size_t size);
+
+    virtual unsigned char* getBytes();
+    virtual unsigned int getSize();
+    virtual void reset();
+
+private:
+    typedef enum {
+        VALUE_BOOL,
+        VALUE_INT,
+        VALUE_LONG,
+        VALUE_FLOAT,
+        VALUE_DOUBLE,
+        VALUE_STRING
+    } ValueType;
+
+    struct Value {
+        const char *asset;
+        ValueType type;
+        union {
+            bool boolean;
+            long integer;
+            double number;
+            const char *string;
+        };
+    };
+
+    Value *values;
+    unsigned int maxAssets;
+    unsigned int count = 0;
+
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int size = 0;
+    bool binaryAllowed = false;
+    PayloadFormat format = PAYLOAD_FORMAT_JSON;
+
+    // Remembered choices, keyed by a hash of the asset names and types
+    static const int rememberedCount = 4;
+    uint32_t rememberedKeys[rememberedCount];
+    PayloadFormat rememberedFormats[rememberedCount];
+    unsigned int rememberedNext = 0;
+
+    AutoPayloadStats stats;
+
+    bool add(const char *assetName, ValueType type);
+    uint32_t getKey();
+    template<typename T> void setJson(T &doc, unsigned int index);
+    unsigned int measure(PayloadFormat format, unsigned int deviceIdLength);
+    unsigned int jsonMessageSize(unsigned int index, unsigned int deviceIdLength);
+    void writeCbor(CborWriter &writer);
+    bool encode(PayloadFormat format);
+};
+
+#endif
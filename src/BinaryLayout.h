@@ -0,0 +1,170 @@
+#ifndef BINARY_LAYOUT_H_
+#define BINARY_LAYOUT_H_
+
+#include "BinaryPayload.h"
+#include "BinaryReader.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Describes the binary layout of a struct once, so firmware and decoder
+// can't drift apart:
+//
+//   struct Reading { uint8_t status; bool alarm; uint16_t light; float temperature; uint32_t uptime; };
+//
+//   typedef BinaryLayout<Reading,
+//       BINARY_BITS(Reading, status, 3),
+//       BINARY_BITS(Reading, alarm, 1),
+//       BINARY_BITS(Reading, light, 10),
+//       BINARY_FIELD(Reading, temperature),
+//       BINARY_FIELD_LE(Reading, uptime)> ReadingLayout;
+//
+//   ReadingLayout::encode(payload, reading);   // 2 + 4 + 4 bytes
+//   ReadingLayout::decode(reader, reading);
+//
+// BINARY_FIELD members are written whole and big endian like
+// BinaryPayload::add, BINARY_FIELD_LE little endian, and BINARY_BITS
+// integers are packed like addBits. Field positions and the record size
+// are worked out by the compiler, so encoding is a fixed sequence of
+// stores behind a single capacity check.
+
+template<typename T, typename M, M T::*Member, unsigned int Bits, bool Packed, bool LittleEndian>
+struct BinaryField {
+    static_assert(std::is_arithmetic<M>::value, "BinaryLayout fields have to be numbers or bools");
+    static_assert(!Packed || std::is_integral<M>::value, "Only integers can be bit-packed");
+    static_assert(Bits >= 1 && Bits <= sizeof(M) * 8, "Bit width doesn't fit the member");
+    static_assert(!(Packed && LittleEndian), "Bit-packed fields have no byte order");
+
+    typedef typename std::conditional<sizeof(M) <= 4, uint32_t, uint64_t>::type Word;
+
+    static const unsigned int bits = Bits;
+    static const bool packed = Packed;
+
+    // Whole fields start on a byte, which start already is
+    template<unsigned long Start> static void encode(unsigned char *out, const T &record) {
+        Word value = toWord(record.*Member);
+        if (Packed) {
+            if (Bits < sizeof(Word) * 8) {
+                value &= ((Word)1 << (Bits % (sizeof(Word) * 8))) - 1;
+            }
+            unsigned long position = Start;
+            unsigned int remaining = Bits;
+            while (remaining > 0) {
+                unsigned int used = position % 8;
+                unsigned int count = 8 - used < remaining ? 8 - used : remaining;
+                out[position / 8] |= ((value >> (remaining - count)) & ((1U << count) - 1)) << (8 - used - count);
+                position += count;
+                remaining -= count;
+            }
+        } else {
+            for (unsigned int i = 0; i < sizeof(M); i++) {
+                unsigned int shift = LittleEndian ? 8 * i : 8 * (sizeof(M) - 1 - i);
+                out[Start / 8 + i] = value >> shift;
+            }
+        }
+    }
+
+    template<unsigned long Start> static void decode(const unsigned char *in, T &record) {
+        Word value = 0;
+        if (Packed) {
+            unsigned long position = Start;
+            unsigned int remaining = Bits;
+            while (remaining > 0) {
+                unsigned int used = position % 8;
+                unsigned int count = 8 - used < remaining ? 8 - used : remaining;
+                value = (value << count) | ((in[position / 8] >> (8 - used - count)) & ((1U << count) - 1));
+                position += count;
+                remaining -= count;
+            }
+            // Sign extend narrow signed fields
+            if (std::is_signed<M>::value && Bits < sizeof(Word) * 8 && (value >> (Bits - 1)) & 1) {
+                value |= ~(Word)0 << (Bits % (sizeof(Word) * 8));
+            }
+        } else {
+            for (unsigned int i = 0; i < sizeof(M); i++) {
+                unsigned int shift = LittleEndian ? 8 * i : 8 * (sizeof(M) - 1 - i);
+                value |= (Word)in[Start / 8 + i] << shift;
+            }
+        }
+        record.*Member = fromWord<M>(value);
+    }
+
+private:
+    template<typename V> static typename std::enable_if<std::is_integral<V>::value, Word>::type toWord(V value) {
+        return (Word)value;
+    }
+    template<typename V> static typename std::enable_if<std::is_floating_point<V>::value, Word>::type toWord(V value) {
+        Word word;
+        memcpy(&word, &value, sizeof(word));
+        return word;
+    }
+    template<typename V> static typename std::enable_if<std::is_integral<V>::value, V>::type fromWord(Word word) {
+        return (V)word;
+    }
+    template<typename V> static typename std::enable_if<std::is_floating_point<V>::value, V>::type fromWord(Word word) {
+        V value;
+        memcpy(&value, &word, sizeof(value));
+        return value;
+    }
+};
+
+#define BINARY_FIELD(T, member) \
+    BinaryField<T, decltype(T::member), &T::member, sizeof(T::member) * 8, false, false>
+#define BINARY_FIELD_LE(T, member) \
+    BinaryField<T, decltype(T::member), &T::member, sizeof(T::member) * 8, false, true>
+#define BINARY_BITS(T, member, bits) \
+    BinaryField<T, decltype(T::member), &T::member, bits, true, false>
+
+template<typename T, unsigned long Position, typename... Fields> struct BinaryLayoutFields {
+    static const unsigned long end = Position;
+    static void encode(unsigned char *, const T &) {}
+    static void decode(const unsigned char *, T &) {}
+};
+
+template<typename T, unsigned long Position, typename Field, typename... Rest>
+struct BinaryLayoutFields<T, Position, Field, Rest...> {
+    static const unsigned long start = Field::packed ? Position : (Position + 7) / 8 * 8;
+    typedef BinaryLayoutFields<T, start + Field::bits, Rest...> Next;
+    static const unsigned long end = Next::end;
+
+    static void encode(unsigned char *out, const T &record) {
+        Field::template encode<start>(out, record);
+        Next::encode(out, record);
+    }
+
+    static void decode(const unsigned char *in, T &record) {
+        Field::template decode<start>(in, record);
+        Next::decode(in, record);
+    }
+};
+
+template<typename T, typename... Fields> class BinaryLayout {
+    typedef BinaryLayoutFields<T, 0, Fields...> Layout;
+
+public:
+    // Record size in bytes, unused bits of the last byte are zero
+    static const unsigned int size = (Layout::end + 7) / 8;
+    static_assert(size > 0, "BinaryLayout needs at least one field");
+
+    static bool encode(BinaryPayload &payload, const T &record) {
+        unsigned char *out = payload.reserve(size);
+        if (out == NULL)
+            return false;
+
+        memset(out, 0, size);
+        Layout::encode(out, record);
+        return true;
+    }
+
+    static bool decode(BinaryReader &reader, T &record) {
+        const unsigned char *in = reader.getPointer(size);
+        if (in == NULL)
+            return false;
+
+        Layout::decode(in, record);
+        return true;
+    }
+};
+
+#endif
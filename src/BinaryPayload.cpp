@@ -8,8 +8,6 @@
 BinaryPayload::BinaryPayload(unsigned int capacity) {
     this->capacity = capacity;
     buffer = new unsigned char[capacity];
-    uint16_t endianCheck = 0x1;
-    littleEndian = ((char*)&endianCheck)[0] == 1;
     releaseBuffer = true;
 }
 
@@ -20,8 +18,7 @@ BinaryPayload::BinaryPayload(unsigned char *buffer, unsigned int length, unsigne
     this->buffer = buffer;
     this->capacity = capacity;
     offset = length;
-    uint16_t endianCheck = 0x1;
-    littleEndian = ((char*)&endianCheck)[0] == 1;
+    bitPosition = (unsigned long)length * 8;
     releaseBuffer = false;
 }
 
@@ -39,62 +36,199 @@ unsigned int BinaryPayload::getSize() {
 	return offset;
 }
 
+unsigned int BinaryPayload::encodedSize() {
+    return offset;
+}
+
+// The buffer is already the message, so it's written in one go
+size_t BinaryPayload::writeTo(Print &out) {
+    if (offset == 0) {
+        return 0;
+    }
+    return out.write(buffer, offset);
+}
+
 void BinaryPayload::reset() {
 	this->offset = 0;
+	this->bitPosition = 0;
 }
 
-template<typename T> bool BinaryPayload::add(T t) {
-    auto *arr = static_cast<unsigned char*>(static_cast<void*>(&t));
+bool BinaryPayload::addBits(uint32_t value, unsigned int nbits) {
+    if (nbits == 0 || nbits > 32)
+        return false;
 
-    if (sizeof(t) + offset > capacity)
+    // Anything added since the last bits starts a fresh byte
+    if ((bitPosition + 7) / 8 != offset) {
+        bitPosition = (unsigned long)offset * 8;
+    }
+    if ((bitPosition + nbits + 7) / 8 > capacity)
         return false;
 
-    if (littleEndian) {
-        for (int i = sizeof(t) - 1; i >= 0; --i) {
-            buffer[offset++] = arr[i];
-        }
-    } else {
-        for (int i = 0; i < sizeof(t); ++i) {
-            buffer[offset++] = arr[i];
+    if (nbits < 32) {
+        value &= (1UL << nbits) - 1;
+    }
+    while (nbits > 0) {
+        unsigned int used = bitPosition % 8;
+        unsigned int count = 8 - used < nbits ? 8 - used : nbits;
+        unsigned char bits = (value >> (nbits - count)) & ((1 << count) - 1);
+        if (used == 0) {
+            buffer[bitPosition / 8] = 0;
         }
+        buffer[bitPosition / 8] |= bits << (8 - used - count);
+        bitPosition += count;
+        nbits -= count;
     }
-
+    offset = (bitPosition + 7) / 8;
     return true;
 }
 
-template<> bool BinaryPayload::add<String>(String t) {
-    if (t.length() + offset > capacity)
+bool BinaryPayload::addQuantized(float value, const Quantization &quantization) {
+    if (!quantization.isValid())
         return false;
+    int32_t quantized = quantization.quantize(value);
+    switch (quantization.bits) {
+        case 8:
+            return add((int8_t)quantized);
+        case 16:
+            return add((int16_t)quantized);
+        case 32:
+            return add(quantized);
+        default:
+            return addBits((uint32_t)quantized, quantization.bits);
+    }
+}
+
+unsigned char *BinaryPayload::reserve(unsigned int size) {
+    if (size > capacity - offset)
+        return NULL;
+
+    unsigned char *reserved = buffer + offset;
+    offset += size;
+    return reserved;
+}
+
+unsigned long BinaryPayload::getFreeBits() {
+    if ((bitPosition + 7) / 8 == offset) {
+        return (unsigned long)capacity * 8 - bitPosition;
+    }
+    return (unsigned long)(capacity - offset) * 8;
+}
 
-    for (int i = 0; i < t.length(); ++i) {
-        buffer[offset++] = t[i];
+bool BinaryPayload::addVarint(uint64_t value) {
+    if (value < 0x80) {
+        if (offset + 1 > capacity)
+            return false;
+        buffer[offset++] = value;
+        return true;
+    }
+    if (value < 0x4000) {
+        if (offset + 2 > capacity)
+            return false;
+        buffer[offset++] = value | 0x80;
+        buffer[offset++] = value >> 7;
+        return true;
     }
 
+    unsigned int length = 3;
+    for (uint64_t rest = value >> 21; rest != 0; rest >>= 7) {
+        length++;
+    }
+    if (offset + length > capacity)
+        return false;
+
+    while (value >= 0x80) {
+        buffer[offset++] = value | 0x80;
+        value >>= 7;
+    }
+    buffer[offset++] = value;
     return true;
 }
 
-template<> bool BinaryPayload::add<const char*>(const char *t) {
-    if (strlen(t) + offset > capacity)
-        return false;
+bool BinaryPayload::addZigzag(int64_t value) {
+    return addVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
 
-    for (int i = 0; i < strlen(t); ++i) {
-        buffer[offset++] = t[i];
+// Values go out big endian; the byte order of the target is known at compile time
+template<typename T> static inline void writeBigEndian(unsigned char *out, T t) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (sizeof(T) == 2) {
+        uint16_t bits;
+        memcpy(&bits, &t, 2);
+        bits = __builtin_bswap16(bits);
+        memcpy(out, &bits, 2);
+    } else if (sizeof(T) == 4) {
+        uint32_t bits;
+        memcpy(&bits, &t, 4);
+        bits = __builtin_bswap32(bits);
+        memcpy(out, &bits, 4);
+    } else if (sizeof(T) == 8) {
+        uint64_t bits;
+        memcpy(&bits, &t, 8);
+        bits = __builtin_bswap64(bits);
+        memcpy(out, &bits, 8);
+    } else {
+        auto *arr = static_cast<unsigned char*>(static_cast<void*>(&t));
+        for (int i = sizeof(T) - 1; i >= 0; --i) {
+            *out++ = arr[i];
+        }
+    }
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    memcpy(out, &t, sizeof(T));
+#else
+    // Without __BYTE_ORDER__ the byte order is checked at runtime
+    const uint16_t probe = 1;
+    auto *arr = static_cast<unsigned char*>(static_cast<void*>(&t));
+    bool littleEndian = *(const unsigned char *)&probe == 1;
+    for (unsigned int i = 0; i < sizeof(T); i++) {
+        out[i] = arr[littleEndian ? sizeof(T) - 1 - i : i];
     }
+#endif
+}
 
+template<typename T> bool BinaryPayload::add(T t) {
+    if (sizeof(t) + offset > capacity)
+        return false;
+
+    writeBigEndian(buffer + offset, t);
+    offset += sizeof(t);
     return true;
 }
 
-template<> bool BinaryPayload::add(char *t) {
-    if (strlen(t) + offset > capacity)
+template<typename T> bool BinaryPayload::addArray(const T *values, unsigned int count) {
+    if (count > (capacity - offset) / sizeof(T))
         return false;
 
-    for (int i = 0; i < strlen(t); ++i) {
-        buffer[offset++] = t[i];
+    unsigned char *out = buffer + offset;
+    for (unsigned int i = 0; i < count; i++, out += sizeof(T)) {
+        writeBigEndian(out, values[i]);
     }
+    offset += count * sizeof(T);
+    return true;
+}
 
+template<> bool BinaryPayload::add<String>(String t) {
+    if (t.length() + offset > capacity)
+        return false;
+
+    memcpy(buffer + offset, t.c_str(), t.length());
+    offset += t.length();
+    return true;
+}
+
+template<> bool BinaryPayload::add<const char*>(const char *t) {
+    unsigned int length = strlen(t);
+    if (length + offset > capacity)
+        return false;
+
+    memcpy(buffer + offset, t, length);
+    offset += length;
     return true;
 }
 
+template<> bool BinaryPayload::add(char *t) {
+    return add<const char*>(t);
+}
+
 template<> bool BinaryPayload::add(GeoLocation location) {
     add(location.latitude);
     add(location.longitude);
@@ -104,8 +238,21 @@ template<> bool BinaryPayload::add(GeoLocation location) {
     return true;
 }
 
-template bool BinaryPayload::add(int t);
-template bool BinaryPayload::add(bool t);
-template bool BinaryPayload::add(float t);
-template bool BinaryPayload::add(double t);
+#define BINARY_PAYLOAD_INSTANTIATE(T) \
+    template bool BinaryPayload::add(T t); \
+    template bool BinaryPayload::addArray(const T *values, unsigned int count);
+
+BINARY_PAYLOAD_INSTANTIATE(bool)
+BINARY_PAYLOAD_INSTANTIATE(signed char)
+BINARY_PAYLOAD_INSTANTIATE(unsigned char)
+BINARY_PAYLOAD_INSTANTIATE(short)
+BINARY_PAYLOAD_INSTANTIATE(unsigned short)
+BINARY_PAYLOAD_INSTANTIATE(int)
+BINARY_PAYLOAD_INSTANTIATE(unsigned int)
+BINARY_PAYLOAD_INSTANTIATE(long)
+BINARY_PAYLOAD_INSTANTIATE(unsigned long)
+BINARY_PAYLOAD_INSTANTIATE(long long)
+BINARY_PAYLOAD_INSTANTIATE(unsigned long long)
+BINARY_PAYLOAD_INSTANTIATE(float)
+BINARY_PAYLOAD_INSTANTIATE(double)
 template bool BinaryPayload::add(GeoLocation location);
@@ -2,6 +2,7 @@
 #define BINARY_PAYLOAD_H_
 
 #include "Payload.h"
+#include "Quantization.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -13,18 +14,38 @@ public:
     ~BinaryPayload();
 
     template<typename T> bool add(T t);
+    // Appends count values at once, or nothing if they don't all fit
+    template<typename T> bool addArray(const T *values, unsigned int count);
+    // Packs the low nbits (1 to 32) of value most significant bit first.
+    // Consecutive calls share bytes; any other add starts at the next byte.
+    bool addBits(uint32_t value, unsigned int nbits);
+    // LEB128: 7 bits per byte, so values below 128 take a single byte.
+    // addZigzag maps small negative values to small varints as well.
+    bool addVarint(uint64_t value);
+    bool addZigzag(int64_t value);
+    // Adds value as an integer of quantization.bits bits: whole bytes for
+    // 8, 16 and 32 bits, packed like addBits otherwise. False if the
+    // quantization isn't valid
+    bool addQuantized(float value, const Quantization &quantization);
+    // Claims size bytes to be filled in directly, or returns NULL if they don't fit
+    unsigned char *reserve(unsigned int size);
+    // Bits that still fit, counting the unused end of a bit-packed byte
+    unsigned long getFreeBits();
 
     virtual unsigned char* getBytes();
     virtual unsigned int getSize();
     virtual void reset();
+    virtual unsigned int encodedSize();
+    virtual size_t writeTo(Print &out);
 
 private:
     unsigned char *buffer = NULL;
     unsigned int offset = 0;
     unsigned int capacity;
+    // Bits written up to the end of the last addBits
+    unsigned long bitPosition = 0;
 
     bool releaseBuffer = true;
-    bool littleEndian;
 };
 
 #endif
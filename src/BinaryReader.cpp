@@ -0,0 +1,216 @@
+#include "BinaryReader.h"
+
+BinaryReader::BinaryReader(const unsigned char *data, unsigned int size) {
+    this->data = data;
+    this->size = size;
+}
+
+unsigned int BinaryReader::getRemaining() {
+    return size - offset;
+}
+
+template<typename T> bool BinaryReader::read(T &t) {
+    if (sizeof(T) > size - offset)
+        return false;
+
+    unsigned char *arr = static_cast<unsigned char*>(static_cast<void*>(&t));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (unsigned int i = 0; i < sizeof(T); i++) {
+        arr[i] = data[offset + sizeof(T) - 1 - i];
+    }
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    memcpy(arr, data + offset, sizeof(T));
+#else
+    // Without __BYTE_ORDER__ the byte order is checked at runtime
+    const uint16_t probe = 1;
+    bool littleEndian = *(const unsigned char *)&probe == 1;
+    for (unsigned int i = 0; i < sizeof(T); i++) {
+        arr[i] = data[offset + (littleEndian ? sizeof(T) - 1 - i : i)];
+    }
+#endif
+    offset += sizeof(T);
+    return true;
+}
+
+bool BinaryReader::readBytes(void *to, unsigned int count) {
+    if (count > size - offset)
+        return false;
+
+    memcpy(to, data + offset, count);
+    offset += count;
+    return true;
+}
+
+const unsigned char *BinaryReader::getPointer(unsigned int count) {
+    if (count > size - offset)
+        return NULL;
+
+    const unsigned char *pointer = data + offset;
+    offset += count;
+    return pointer;
+}
+
+bool BinaryReader::readBits(uint32_t &value, unsigned int nbits) {
+    if (nbits == 0 || nbits > 32)
+        return false;
+
+    if ((bitPosition + 7) / 8 != offset) {
+        bitPosition = (unsigned long)offset * 8;
+    }
+    if ((bitPosition + nbits + 7) / 8 > size)
+        return false;
+
+    uint32_t result = 0;
+    while (nbits > 0) {
+        unsigned int used = bitPosition % 8;
+        unsigned int count = 8 - used < nbits ? 8 - used : nbits;
+        result = (result << count) | ((data[bitPosition / 8] >> (8 - used - count)) & ((1 << count) - 1));
+        bitPosition += count;
+        nbits -= count;
+    }
+    offset = (bitPosition + 7) / 8;
+    value = result;
+    return true;
+}
+
+bool BinaryReader::readVarint(uint64_t &value) {
+    uint64_t result = 0;
+    unsigned int shift = 0;
+    for (unsigned int i = offset; i < size && shift < 64; i++, shift += 7) {
+        result |= (uint64_t)(data[i] & 0x7F) << shift;
+        if (!(data[i] & 0x80)) {
+            offset = i + 1;
+            value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BinaryReader::readZigzag(int64_t &value) {
+    uint64_t encoded;
+    if (!readVarint(encoded))
+        return false;
+
+    value = (int64_t)(encoded >> 1) ^ -(int64_t)(encoded & 1);
+    return true;
+}
+
+BinarySeriesReader::BinarySeriesReader(BinaryReader &reader) {
+    this->reader = &reader;
+}
+
+bool BinarySeriesReader::hasError() {
+    return error;
+}
+
+bool BinarySeriesReader::readSigned(int32_t &value, unsigned int nbits) {
+    uint32_t bits;
+    if (!reader->readBits(bits, nbits))
+        return false;
+
+    if (nbits < 32 && (bits & (1UL << (nbits - 1)))) {
+        bits |= ~((1UL << nbits) - 1);
+    }
+    value = (int32_t)bits;
+    return true;
+}
+
+bool BinarySeriesReader::next(uint32_t &timestamp, float &value) {
+    if (ended || error)
+        return false;
+
+    if (!started) {
+        // A series without samples is just the end marker
+        uint32_t marker;
+        if (!reader->readBits(marker, 1)) {
+            error = true;
+            return false;
+        }
+        if (marker == 1) {
+            if (!reader->readBits(marker, 4) || marker != 15) {
+                error = true;
+                return false;
+            }
+            ended = true;
+            return false;
+        }
+        if (!reader->readBits(lastTimestamp, 32) || !reader->readBits(lastValue, 32)) {
+            error = true;
+            return false;
+        }
+        started = true;
+    } else {
+        // Count the leading ones of the timestamp code
+        unsigned int ones = 0;
+        uint32_t bit = 1;
+        while (ones < 5 && reader->readBits(bit, 1) && bit == 1) {
+            ones++;
+        }
+        if (ones < 5 && bit == 1) {
+            error = true;
+            return false;
+        }
+        if (ones == 5) {
+            ended = true;
+            return false;
+        }
+
+        static const unsigned int changeBits[] = {0, 7, 9, 12, 32};
+        int32_t change = 0;
+        if (ones > 0 && !readSigned(change, changeBits[ones])) {
+            error = true;
+            return false;
+        }
+        lastDelta += (uint32_t)change;
+        lastTimestamp += lastDelta;
+
+        uint32_t control;
+        if (!reader->readBits(control, 1)) {
+            error = true;
+            return false;
+        }
+        if (control == 1) {
+            if (!reader->readBits(control, 1)) {
+                error = true;
+                return false;
+            }
+            if (control == 1) {
+                uint32_t length;
+                if (!reader->readBits(leading, 5) || !reader->readBits(length, 5)) {
+                    error = true;
+                    return false;
+                }
+                trailing = 32 - leading - (length + 1);
+                if (leading + length + 1 > 32) {
+                    error = true;
+                    return false;
+                }
+            }
+            uint32_t meaningful;
+            if (!reader->readBits(meaningful, 32 - leading - trailing)) {
+                error = true;
+                return false;
+            }
+            lastValue ^= meaningful << trailing;
+        }
+    }
+
+    timestamp = lastTimestamp;
+    memcpy(&value, &lastValue, sizeof(value));
+    return true;
+}
+
+template bool BinaryReader::read(bool &t);
+template bool BinaryReader::read(signed char &t);
+template bool BinaryReader::read(unsigned char &t);
+template bool BinaryReader::read(short &t);
+template bool BinaryReader::read(unsigned short &t);
+template bool BinaryReader::read(int &t);
+template bool BinaryReader::read(unsigned int &t);
+template bool BinaryReader::read(long &t);
+template bool BinaryReader::read(unsigned long &t);
+template bool BinaryReader::read(long long &t);
+template bool BinaryReader::read(unsigned long long &t);
+template bool BinaryReader::read(float &t);
+template bool BinaryReader::read(double &t);
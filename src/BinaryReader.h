@@ -0,0 +1,56 @@
+#ifndef BINARY_READER_H_
+#define BINARY_READER_H_
+
+// Doesn't depend on the Arduino core, so it also builds on a host
+#include <string.h>
+#include <stdint.h>
+
+// Reads back what BinaryPayload wrote: big endian values and bit fields.
+// Every read returns false, leaving the value untouched, once the data
+// runs out.
+class BinaryReader {
+public:
+    BinaryReader(const unsigned char *data, unsigned int size);
+
+    template<typename T> bool read(T &t);
+    bool readBytes(void *to, unsigned int count);
+    // Skips count bytes and returns where they start, or NULL if there aren't enough
+    const unsigned char *getPointer(unsigned int count);
+    // Bit fields packed by addBits; any other read starts at the next byte
+    bool readBits(uint32_t &value, unsigned int nbits);
+    bool readVarint(uint64_t &value);
+    bool readZigzag(int64_t &value);
+
+    unsigned int getRemaining();
+
+private:
+    const unsigned char *data;
+    unsigned int size;
+    unsigned int offset = 0;
+    unsigned long bitPosition = 0;
+};
+
+// Reads a series written by BinarySeriesWriter. next() returns false at the
+// end marker, or with an error if the data is cut short.
+class BinarySeriesReader {
+public:
+    BinarySeriesReader(BinaryReader &reader);
+
+    bool next(uint32_t &timestamp, float &value);
+    bool hasError();
+
+private:
+    BinaryReader *reader;
+    bool started = false;
+    bool ended = false;
+    bool error = false;
+    uint32_t lastTimestamp = 0;
+    uint32_t lastDelta = 0;
+    uint32_t lastValue = 0;
+    uint32_t leading = 0;
+    uint32_t trailing = 0;
+
+    bool readSigned(int32_t &value, unsigned int nbits);
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include <string.h>
+
+#include "BinarySeries.h"
+
+// First sample:     0 + 32 bits timestamp + 32 bits value, so any start
+//                   time can be told apart from the end marker
+// Timestamp codes:  0  same interval
+//                   10     + 7 bits   interval changed by -64..63
+//                   110    + 9 bits   -256..255
+//                   1110   + 12 bits  -2048..2047
+//                   11110  + 32 bits  anything else
+//                   11111             end of series
+// Value codes:      0  same value
+//                   10 + bits         XOR fits the previous leading/trailing zeros
+//                   11 + 5 bits leading zeros + 5 bits length - 1 + bits
+static const unsigned int END_BITS = 5;
+
+BinarySeriesWriter::BinarySeriesWriter(BinaryPayload &payload) {
+    this->payload = &payload;
+    reset();
+}
+
+void BinarySeriesWriter::reset() {
+    sampleCount = 0;
+    lastTimestamp = 0;
+    lastDelta = 0;
+    lastValue = 0;
+    leading = 32;
+    trailing = 0;
+}
+
+unsigned int BinarySeriesWriter::getSampleCount() {
+    return sampleCount;
+}
+
+bool BinarySeriesWriter::add(uint32_t timestamp, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    if (sampleCount == 0) {
+        if (payload->getFreeBits() < 1 + 64 + END_BITS)
+            return false;
+        payload->addBits(0, 1);
+        payload->addBits(timestamp, 32);
+        payload->addBits(bits, 32);
+        lastTimestamp = timestamp;
+        lastValue = bits;
+        sampleCount++;
+        return true;
+    }
+
+    // Unsigned, so jumps across the whole range wrap instead of overflowing
+    uint32_t delta = timestamp - lastTimestamp;
+    int32_t change = (int32_t)(delta - lastDelta);
+    unsigned int timeCode, timeCodeBits, timeBits;
+    if (change == 0) {
+        timeCode = 0; timeCodeBits = 1; timeBits = 0;
+    } else if (change >= -64 && change <= 63) {
+        timeCode = 2; timeCodeBits = 2; timeBits = 7;
+    } else if (change >= -256 && change <= 255) {
+        timeCode = 6; timeCodeBits = 3; timeBits = 9;
+    } else if (change >= -2048 && change <= 2047) {
+        timeCode = 14; timeCodeBits = 4; timeBits = 12;
+    } else {
+        timeCode = 30; timeCodeBits = 5; timeBits = 32;
+    }
+
+    uint32_t xored = bits ^ lastValue;
+    unsigned int valueBits, newLeading = 0, newTrailing = 0;
+    bool reuse = false;
+    if (xored == 0) {
+        valueBits = 1;
+    } else {
+        newLeading = __builtin_clz(xored);
+        newTrailing = __builtin_ctz(xored);
+        reuse = leading != 32 && newLeading >= leading && newTrailing >= trailing;
+        if (reuse) {
+            valueBits = 2 + 32 - leading - trailing;
+        } else {
+            valueBits = 2 + 5 + 5 + 32 - newLeading - newTrailing;
+        }
+    }
+
+    if (payload->getFreeBits() < timeCodeBits + timeBits + valueBits + END_BITS)
+        return false;
+
+    payload->addBits(timeCode, timeCodeBits);
+    if (timeBits > 0) {
+        payload->addBits(change, timeBits);
+    }
+
+    if (xored == 0) {
+        payload->addBits(0, 1);
+    } else if (reuse) {
+        payload->addBits(2, 2);
+        payload->addBits(xored >> trailing, 32 - leading - trailing);
+    } else {
+        unsigned int length = 32 - newLeading - newTrailing;
+        payload->addBits(3, 2);
+        payload->addBits(newLeading, 5);
+        payload->addBits(length - 1, 5);
+        payload->addBits(xored >> newTrailing, length);
+        leading = newLeading;
+        trailing = newTrailing;
+    }
+
+    lastTimestamp = timestamp;
+    lastDelta = delta;
+    lastValue = bits;
+    sampleCount++;
+    return true;
+}
+
+bool BinarySeriesWriter::finish() {
+    return payload->addBits(31, END_BITS);
+}
@@ -0,0 +1,35 @@
+#ifndef BINARY_SERIES_H_
+#define BINARY_SERIES_H_
+
+#include "BinaryPayload.h"
+
+#include <stdint.h>
+
+// Appends (timestamp, float) samples to a BinaryPayload as bit fields, the
+// way Facebook's Gorilla does: timestamps as the change of their interval,
+// values XOR'ed with the previous one. A sample at the usual interval with
+// an unchanged value takes 2 bits. Read it back with BinarySeriesReader.
+//
+// Call finish() before sending; it ends the series with a 5 bit marker,
+// which add() always keeps room for.
+class BinarySeriesWriter {
+public:
+    BinarySeriesWriter(BinaryPayload &payload);
+
+    bool add(uint32_t timestamp, float value);
+    bool finish();
+    unsigned int getSampleCount();
+    // Starts a new series, e.g. after the payload has been reset
+    void reset();
+
+private:
+    BinaryPayload *payload;
+    unsigned int sampleCount;
+    uint32_t lastTimestamp;
+    uint32_t lastDelta;
+    uint32_t lastValue;
+    unsigned int leading;
+    unsigned int trailing;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "CborAssetDictionary.h"
+
+CborAssetDictionary::CborAssetDictionary(unsigned int capacity) {
+    this->capacity = capacity;
+    assetNames = new const char*[capacity];
+    hashes = new uint32_t[capacity];
+}
+
+CborAssetDictionary::~CborAssetDictionary() {
+    delete[] assetNames;
+    delete[] hashes;
+}
+
+// The hash CborKey works out at compile time, so lookups compare names
+// only once their hashes match
+uint32_t CborAssetDictionary::hashName(const char *assetName) {
+    uint32_t hash = 0;
+    while (*assetName) {
+        hash = hash * 16777619u + (unsigned char)*assetName++;
+    }
+    return hash;
+}
+
+int CborAssetDictionary::add(const char *assetName) {
+    int key = find(assetName);
+    if (key >= 0) {
+        return key;
+    }
+    if (count >= capacity) {
+        return -1;
+    }
+    assetNames[count] = assetName;
+    hashes[count] = hashName(assetName);
+    return count++;
+}
+
+int CborAssetDictionary::find(const char *assetName) {
+    // Sketches usually pass the very pointer they registered
+    uint32_t hash = hashName(assetName);
+    for (unsigned int i = 0; i < count; i++) {
+        if (assetNames[i] == assetName || (hashes[i] == hash && strcmp(assetNames[i], assetName) == 0)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int CborAssetDictionary::find(const CborKey &assetKey) {
+    for (unsigned int i = 0; i < count; i++) {
+        if (hashes[i] == assetKey.hash
+                && (assetNames[i] == assetKey.name || strcmp(assetNames[i], assetKey.name) == 0)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+unsigned int CborAssetDictionary::getCount() {
+    return count;
+}
+
+void CborAssetDictionary::write(CborWriter &writer) {
+    writer.writeMap(count);
+    for (unsigned int i = 0; i < count; i++) {
+        writer.writeInt((uint32_t)i);
+        writer.writeString(assetNames[i], strlen(assetNames[i]));
+    }
+}
+
+unsigned int CborAssetDictionary::getEncodedSize() {
+    CborCountingOutput counter;
+    CborWriter writer(counter);
+    write(writer);
+    return counter.getSize();
+}
@@ -0,0 +1,41 @@
+#ifndef CBOR_ASSET_DICTIONARY_H_
+#define CBOR_ASSET_DICTIONARY_H_
+
+#include "CborEncoder.h"
+
+#include <string.h>
+#include <stdint.h>
+
+// Device::send() publishes the dictionary (retained) to device/<id>/state/dictionary
+// before the first payload using it, and payloads using its keys to
+// device/<id>/state/keyed, as the platform itself only resolves asset names
+#define DICTIONARY_TOPIC_SUFFIX "/dictionary"
+#define KEYED_TOPIC_SUFFIX "/keyed"
+
+// Maps asset names to small integer keys (their registration order), so a
+// CborPayload using it writes a 1-2 byte key instead of the full name.
+// Register every asset in setup(); names are not copied.
+class CborAssetDictionary {
+public:
+    CborAssetDictionary(unsigned int capacity = 16);
+    ~CborAssetDictionary();
+
+    int add(const char *assetName);
+    int find(const char *assetName);
+    int find(const CborKey &assetKey);
+    unsigned int getCount();
+
+    // The { key: "name", ... } map the receiving side needs to resolve keys
+    void write(CborWriter &writer);
+    unsigned int getEncodedSize();
+
+private:
+    const char **assetNames;
+    uint32_t *hashes;
+    unsigned int capacity;
+    unsigned int count = 0;
+
+    static uint32_t hashName(const char *assetName);
+};
+
+#endif
@@ -0,0 +1,344 @@
+#include "CborBatch.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+CborBatch::CborBatch(unsigned int capacity) {
+    this->capacity = capacity;
+    messages = new uint32_t[capacity];
+    assets = new uint16_t[capacity];
+    types = new uint8_t[capacity];
+    integers = new int64_t[capacity];
+    numbers = new double[capacity];
+    strings = new CborStringView[capacity];
+    timestamps = new int64_t[capacity];
+    latitudes = new double[capacity];
+    longitudes = new double[capacity];
+}
+
+CborBatch::~CborBatch() {
+    delete[] messages;
+    delete[] assets;
+    delete[] types;
+    delete[] integers;
+    delete[] numbers;
+    delete[] strings;
+    delete[] timestamps;
+    delete[] latitudes;
+    delete[] longitudes;
+}
+
+void CborBatch::clear() {
+    size = 0;
+}
+
+// Skips whole blocks of ASCII, which is what asset names almost always are
+static unsigned int skipAscii(const unsigned char *data, unsigned int i, unsigned int length) {
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+        if (_mm_movemask_epi8(block) != 0) break;
+    }
+#else
+    for (; i + 8 <= length; i += 8) {
+        uint64_t block;
+        memcpy(&block, data + i, sizeof(block));
+        if (block & 0x8080808080808080ULL) break;
+    }
+#endif
+    while (i < length && data[i] < 0x80) i++;
+    return i;
+}
+
+static bool isValidUtf8(const unsigned char *data, unsigned int length) {
+    unsigned int i = 0;
+    while ((i = skipAscii(data, i, length)) < length) {
+        unsigned char lead = data[i];
+        unsigned int extra;
+        uint32_t codePoint;
+        if ((lead & 0xE0) == 0xC0) {
+            extra = 1;
+            codePoint = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            extra = 2;
+            codePoint = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            extra = 3;
+            codePoint = lead & 0x07;
+        } else {
+            return false;
+        }
+        if (length - i <= extra) {
+            return false;
+        }
+        for (unsigned int k = 1; k <= extra; k++) {
+            if ((data[i + k] & 0xC0) != 0x80) return false;
+            codePoint = (codePoint << 6) | (data[i + k] & 0x3F);
+        }
+        // Overlong forms, surrogates and anything past U+10FFFF
+        if ((extra == 1 && codePoint < 0x80) ||
+            (extra == 2 && (codePoint < 0x800 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))) ||
+            (extra == 3 && (codePoint < 0x10000 || codePoint > 0x10FFFF))) {
+            return false;
+        }
+        i += extra + 1;
+    }
+    return true;
+}
+
+static uint32_t hashName(const char *name, unsigned int length) {
+    uint32_t hash = 2166136261u;
+    for (unsigned int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+CborBatchDecoder::CborBatchDecoder(unsigned int maxAssets, unsigned int nameCapacity) {
+    if (maxAssets > 65535) {
+        maxAssets = 65535;
+    }
+    this->maxAssets = maxAssets;
+    this->nameCapacity = nameCapacity;
+    names = new char[nameCapacity];
+    nameOffsets = new unsigned int[maxAssets];
+    nameLengths = new unsigned int[maxAssets];
+    nameHashes = new uint32_t[maxAssets];
+    nameIsKey = new bool[maxAssets];
+
+    // Keep the open addressing table at most half full
+    unsigned int tableSize = 2;
+    while (tableSize < 2 * maxAssets) tableSize *= 2;
+    tableMask = tableSize - 1;
+    table = new uint16_t[tableSize];
+    memset(table, 0, tableSize * sizeof(uint16_t));
+}
+
+CborBatchDecoder::~CborBatchDecoder() {
+    delete[] names;
+    delete[] nameOffsets;
+    delete[] nameLengths;
+    delete[] nameHashes;
+    delete[] nameIsKey;
+    delete[] table;
+}
+
+const char *CborBatchDecoder::getAssetName(uint16_t asset) {
+    return asset < assetCount ? names + nameOffsets[asset] : NULL;
+}
+
+bool CborBatchDecoder::isDictionaryKey(uint16_t asset) {
+    return asset < assetCount && nameIsKey[asset];
+}
+
+unsigned int CborBatchDecoder::getAssetCount() {
+    return assetCount;
+}
+
+unsigned long CborBatchDecoder::getFailedCount() {
+    return failedCount;
+}
+
+// Returns the asset id, or -1 if the name is invalid or there's no room left.
+// Integer keys are kept apart from names, so key 3 isn't the asset named "3".
+int CborBatchDecoder::intern(const char *name, unsigned int length, bool isKey) {
+    uint32_t hash = hashName(name, length);
+    unsigned int slot = hash & tableMask;
+    while (table[slot] != 0) {
+        unsigned int asset = table[slot] - 1;
+        if (nameHashes[asset] == hash && nameIsKey[asset] == isKey && nameLengths[asset] == length &&
+            memcmp(names + nameOffsets[asset], name, length) == 0) {
+            return asset;
+        }
+        slot = (slot + 1) & tableMask;
+    }
+
+    if (assetCount >= maxAssets || nameCapacity - nameSize < length + 1) {
+        return -1;
+    }
+    if (!isKey && !isValidUtf8((const unsigned char *)name, length)) {
+        return -1;
+    }
+
+    memcpy(names + nameSize, name, length);
+    names[nameSize + length] = 0;
+    nameOffsets[assetCount] = nameSize;
+    nameLengths[assetCount] = length;
+    nameHashes[assetCount] = hash;
+    nameIsKey[assetCount] = isKey;
+    nameSize += length + 1;
+    table[slot] = ++assetCount;
+    return assetCount - 1;
+}
+
+// Decodes as many whole messages as fit and returns how many were consumed.
+// Malformed messages are consumed without adding rows.
+unsigned int CborBatchDecoder::decode(const unsigned char *const *messages, const unsigned int *lengths,
+        unsigned int count, CborBatch &batch) {
+    unsigned int message = 0;
+    for (; message < count; message++) {
+        unsigned int firstRow = batch.size;
+        CborInput input((void *)messages[message], lengths[message]);
+        CborParser parser(input);
+        if (decodeMessage(parser, message, batch)) {
+            continue;
+        }
+        bool full = batch.size == batch.capacity;
+        batch.size = firstRow;
+        if (full && firstRow > 0) {
+            // Retry this message in an empty batch
+            break;
+        }
+        failedCount++;
+    }
+    return message;
+}
+
+bool CborBatchDecoder::decodeMessage(CborParser &parser, uint32_t message, CborBatch &batch) {
+    unsigned int meta = 1;
+    if (!parser.next()) return false;
+    if (parser.type() == CBOR_TYPE_TAG) {
+        if (parser.asTag() != 120 || !parser.next() || parser.type() != CBOR_TYPE_ARRAY) return false;
+        meta = parser.asCount();
+        if (meta < 1 || meta > 3 || !parser.next()) return false;
+    }
+    if (parser.type() != CBOR_TYPE_MAP) return false;
+
+    unsigned int firstRow = batch.size;
+    unsigned int entries = parser.asCount();
+    for (unsigned int entry = 0; entry < entries; entry++) {
+        if (batch.size == batch.capacity || !parser.next()) return false;
+
+        int asset;
+        if (parser.type() == CBOR_TYPE_STRING) {
+            CborStringView key = parser.asStringView();
+            asset = intern(key.data, key.length, false);
+        } else if (parser.type() == CBOR_TYPE_INTEGER && !parser.isNegative()) {
+            char digits[21];
+            unsigned int position = sizeof(digits);
+            uint64_t key = parser.asUnsigned();
+            do {
+                digits[--position] = '0' + key % 10;
+                key /= 10;
+            } while (key > 0);
+            asset = intern(digits + position, sizeof(digits) - position, true);
+        } else {
+            return false;
+        }
+        if (asset < 0) return false;
+
+        unsigned int row = batch.size;
+        batch.messages[row] = message;
+        batch.assets[row] = asset;
+        batch.latitudes[row] = NAN;
+        batch.longitudes[row] = NAN;
+        if (!parser.next() || !decodeValue(parser, row, batch)) return false;
+        batch.size++;
+    }
+
+    int64_t timestamp = CBOR_BATCH_NO_TIMESTAMP;
+    double latitude = NAN, longitude = NAN, altitude;
+    if (meta >= 2) {
+        if (!parser.next()) return false;
+        if (parser.type() == CBOR_TYPE_TAG) {
+            if (parser.asTag() != 1 || !parser.next() || parser.type() != CBOR_TYPE_INTEGER || !parser.fitsInt()) return false;
+            timestamp = parser.asInt();
+        } else if (parser.type() != CBOR_TYPE_SPECIAL || parser.asSpecial() != 22) {
+            return false;
+        }
+    }
+    if (meta == 3) {
+        if (!parser.next() || parser.type() != CBOR_TYPE_TAG || parser.asTag() != 103) return false;
+        if (!decodeLocation(parser, latitude, longitude, altitude)) return false;
+    }
+
+    for (unsigned int row = firstRow; row < batch.size; row++) {
+        batch.timestamps[row] = timestamp;
+        if (batch.types[row] != CBOR_VALUE_LOCATION) {
+            batch.latitudes[row] = latitude;
+            batch.longitudes[row] = longitude;
+        }
+    }
+    return true;
+}
+
+bool CborBatchDecoder::decodeValue(CborParser &parser, unsigned int row, CborBatch &batch) {
+    switch (parser.type()) {
+        case CBOR_TYPE_INTEGER:
+            // Beyond int64_t only the number is kept
+            batch.types[row] = parser.fitsInt() ? CBOR_VALUE_INTEGER : CBOR_VALUE_FLOAT;
+            batch.integers[row] = parser.asInt();
+            batch.numbers[row] = parser.asFloat();
+            return true;
+        case CBOR_TYPE_FLOAT:
+            batch.types[row] = CBOR_VALUE_FLOAT;
+            batch.numbers[row] = parser.asFloat();
+            return true;
+        case CBOR_TYPE_STRING:
+        case CBOR_TYPE_BYTES:
+            batch.types[row] = parser.type() == CBOR_TYPE_STRING ? CBOR_VALUE_STRING : CBOR_VALUE_BYTES;
+            batch.strings[row] = parser.asStringView();
+            return true;
+        case CBOR_TYPE_SPECIAL:
+            if (parser.asSpecial() == 20 || parser.asSpecial() == 21) {
+                batch.types[row] = CBOR_VALUE_BOOL;
+                batch.integers[row] = parser.asBool();
+                batch.numbers[row] = parser.asBool();
+            } else {
+                batch.types[row] = parser.asSpecial() == 22 ? CBOR_VALUE_NULL : CBOR_VALUE_OTHER;
+            }
+            return true;
+        case CBOR_TYPE_TAG:
+            if (parser.asTag() == 103) {
+                batch.types[row] = CBOR_VALUE_LOCATION;
+                return decodeLocation(parser, batch.latitudes[row], batch.longitudes[row], batch.numbers[row]);
+            }
+            if (parser.asTag() == 4) {
+                return decodeDecimal(parser, row, batch);
+            }
+            batch.types[row] = CBOR_VALUE_OTHER;
+            return parser.skip();
+        default:
+            batch.types[row] = CBOR_VALUE_OTHER;
+            return parser.skip();
+    }
+}
+
+// Reads the [latitude, longitude, altitude?] array following a 103 tag
+bool CborBatchDecoder::decodeLocation(CborParser &parser, double &latitude, double &longitude, double &altitude) {
+    if (!parser.next() || parser.type() != CBOR_TYPE_ARRAY) return false;
+    unsigned int count = parser.asCount();
+    if (count < 2 || count > 3) return false;
+    double values[3] = { NAN, NAN, NAN };
+    for (unsigned int i = 0; i < count; i++) {
+        if (!parser.next()) return false;
+        if (parser.type() != CBOR_TYPE_FLOAT && parser.type() != CBOR_TYPE_INTEGER) return false;
+        values[i] = parser.asFloat();
+    }
+    latitude = values[0];
+    longitude = values[1];
+    altitude = values[2];
+    return true;
+}
+
+// Reads the [exponent, mantissa] array following a 4 tag. Mantissas beyond
+// int64_t, i.e. bignums, are left as CBOR_VALUE_OTHER.
+bool CborBatchDecoder::decodeDecimal(CborParser &parser, unsigned int row, CborBatch &batch) {
+    if (!parser.next() || parser.type() != CBOR_TYPE_ARRAY || parser.asCount() != 2) return false;
+    if (!parser.next() || parser.type() != CBOR_TYPE_INTEGER || !parser.fitsInt()) return false;
+    int64_t exponent = parser.asInt();
+    if (!parser.next()) return false;
+    if (parser.type() != CBOR_TYPE_INTEGER || !parser.fitsInt()) {
+        batch.types[row] = CBOR_VALUE_OTHER;
+        return parser.skip();
+    }
+    double mantissa = (double)parser.asInt();
+    // 10^n is exact in a double for small n and 10^-n isn't, so 214e-1
+    // is worked out as 214 / 10 to get the double nearest to 21.4
+    double power = pow(10.0, fabs((double)exponent));
+    batch.types[row] = CBOR_VALUE_FLOAT;
+    batch.numbers[row] = exponent < 0 ? mantissa / power : mantissa * power;
+    return true;
+}
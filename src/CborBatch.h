@@ -0,0 +1,93 @@
+#ifndef CBOR_BATCH_H_
+#define CBOR_BATCH_H_
+
+// Like CborParser this doesn't need the Arduino core; it's meant for
+// services decoding CborPayload messages from many devices on a host.
+#include "CborParser.h"
+
+#include <stdint.h>
+#include <string.h>
+
+typedef enum {
+    CBOR_VALUE_NULL,
+    CBOR_VALUE_BOOL,
+    CBOR_VALUE_INTEGER,
+    CBOR_VALUE_FLOAT,
+    CBOR_VALUE_STRING,
+    CBOR_VALUE_BYTES,
+    CBOR_VALUE_LOCATION,
+    CBOR_VALUE_OTHER
+} CborValueType;
+
+#define CBOR_BATCH_NO_TIMESTAMP INT64_MIN
+
+// Columnar decode output: row i of every array describes one asset value.
+// Numbers are also filled in for integers and booleans, decimal fractions
+// (tag 4) are decoded into numbers as floats, strings point into
+// the decoded message, and locations use latitudes, longitudes and numbers
+// (altitude, NaN if absent). Message level locations fill latitudes and
+// longitudes of every row without one.
+class CborBatch {
+public:
+    CborBatch(unsigned int capacity);
+    ~CborBatch();
+
+    void clear();
+
+    unsigned int size = 0;
+    unsigned int capacity;
+
+    uint32_t *messages;
+    uint16_t *assets;
+    uint8_t *types;
+    int64_t *integers;
+    double *numbers;
+    CborStringView *strings;
+    int64_t *timestamps;
+    double *latitudes;
+    double *longitudes;
+};
+
+// Decodes CborPayload messages (plain asset maps, or IoT data points with tag
+// 120, timestamp tag 1 and location tag 103) into a CborBatch. Asset names
+// are interned into small ids; integer keys (CborAssetDictionary) get ids of
+// their own, named by their decimal text. New names are UTF-8 validated once,
+// with SSE2 on x86 and a word-at-a-time ASCII check elsewhere.
+class CborBatchDecoder {
+public:
+    CborBatchDecoder(unsigned int maxAssets = 1024, unsigned int nameCapacity = 32768);
+    ~CborBatchDecoder();
+
+    unsigned int decode(const unsigned char *const *messages, const unsigned int *lengths,
+        unsigned int count, CborBatch &batch);
+
+    const char *getAssetName(uint16_t asset);
+    // True if the asset was keyed by integer, its name then being the key
+    bool isDictionaryKey(uint16_t asset);
+    unsigned int getAssetCount();
+    unsigned long getFailedCount();
+
+private:
+    char *names;
+    unsigned int nameCapacity;
+    unsigned int nameSize = 0;
+    unsigned int *nameOffsets;
+    unsigned int *nameLengths;
+    uint32_t *nameHashes;
+    bool *nameIsKey;
+    unsigned int maxAssets;
+    unsigned int assetCount = 0;
+
+    uint16_t *table;
+    unsigned int tableMask;
+
+    unsigned long failedCount = 0;
+
+    int intern(const char *name, unsigned int length, bool isKey);
+    bool decodeMessage(CborParser &parser, uint32_t message, CborBatch &batch);
+    bool decodeValue(CborParser &parser, unsigned int row, CborBatch &batch);
+    bool decodeLocation(CborParser &parser, double &latitude, double &longitude, double &altitude);
+    bool decodeDecimal(CborParser &parser, unsigned int row, CborBatch &batch);
+};
+
+#endif
@@ -3,61 +3,168 @@
 
 
 
-CborInput::CborInput(void *data, int size) {
-	this->data = (unsigned char *)data;
-	this->size = size;
-	this->offset = 0;
+CborReader::CborReader(CborInput &input) {
+	this->input = &input;
+	this->state = STATE_TYPE;
 }
 
-CborInput::~CborInput() {}
+CborReader::CborReader(CborInput &input, CborListener &listener) {
+	this->input = &input;
+	this->listener = &listener;
+	this->state = STATE_TYPE;
+}
 
 
-bool CborInput::hasBytes(unsigned int count) {
-	return size - offset >= count;
+CborReader::CborReader(CborListener &listener) {
+	this->input = NULL;
+	this->listener = &listener;
+	this->state = STATE_TYPE;
 }
 
-unsigned char CborInput::getByte() {
-	return data[offset++];
+CborReader::~CborReader() {
+	releaseCarry();
 }
 
-unsigned short CborInput::getShort() {
-	unsigned short value = ((unsigned short)data[offset] << 8) | ((unsigned short)data[offset + 1]);
-	offset += 2;
-	return value;
+void CborReader::releaseCarry() {
+	if(carry != NULL && carry != carryHeader && !(limited && carry == stringArea)) {
+		delete[] carry;
+	}
+	carry = NULL;
+	carryCount = 0;
 }
 
-uint32_t CborInput::getInt() {
-	uint32_t value = ((uint32_t)data[offset] << 24) | ((uint32_t)data[offset + 1] << 16) | ((uint32_t)data[offset + 2] << 8) | ((uint32_t)data[offset + 3]);
-	offset += 4;
-	return value;
+void CborReader::Reset() {
+	releaseCarry();
+	state = STATE_TYPE;
+	depth = 0;
+	itemCount = 0;
 }
 
-uint64_t CborInput::getLong() {
-	uint64_t value = ((uint64_t)data[offset] << 56) | ((uint64_t)data[offset+1] << 48) | ((uint64_t)data[offset+2] << 40) | ((uint64_t)data[offset+3] << 32) | ((uint64_t)data[offset+4] << 24) | ((uint64_t)data[offset+5] << 16) | ((uint64_t)data[offset+6] << 8) | ((uint64_t)data[offset+7]);
-	offset += 8;
-	return value;
-}
+void CborReader::Feed(const unsigned char *data, unsigned int size) {
+	CborInput *previousInput = input;
+
+	// Complete the item left unfinished by the previous chunk first
+	if(carry != NULL) {
+		unsigned int missing = currentLength - carryCount;
+		unsigned int count = size < missing ? size : missing;
+		memcpy(carry + carryCount, data, count);
+		carryCount += count;
+		data += count;
+		size -= count;
+		if(carryCount < currentLength) {
+			return;
+		}
 
-void CborInput::getBytes(void *to, int count) {
-	memcpy(to, data + offset, count);
-	offset += count;
+		CborInput carried(carry, carryCount);
+		input = &carried;
+		Run();
+		input = previousInput;
+		releaseCarry();
+	}
+
+	CborInput chunk((void *)data, size);
+	input = &chunk;
+	Run();
+	input = previousInput;
+
+	// Whatever is left is the start of an item that needs more bytes. The
+	// length comes off the wire, so it's checked before allocating anything.
+	unsigned int remaining = chunk.getRemaining();
+	if(remaining > 0 && state != STATE_ERROR) {
+		bool isData = state == STATE_BYTES_DATA || state == STATE_STRING_DATA;
+		if(isData && limited) {
+			carry = stringArea;
+		} else if(isData && currentLength > CBOR_READER_MAX_CARRY) {
+			Fail("string too long to carry");
+			return;
+		} else if(isData) {
+			carry = new unsigned char[currentLength];
+			if(carry == NULL) {
+				Fail("out of memory");
+				return;
+			}
+		} else {
+			carry = carryHeader;
+		}
+		chunk.getBytes(carry, remaining);
+		carryCount = remaining;
+	}
 }
 
 
-CborReader::CborReader(CborInput &input) {
-	this->input = &input;
-	this->state = STATE_TYPE;
+bool CborReader::SetLimits(unsigned int maxStringLength, unsigned int maxDepth, unsigned long maxItems,
+		unsigned char *scratch, unsigned int scratchSize) {
+	// The depth stack needs aligned storage at the start of scratch
+	unsigned int padding = (sizeof(uint32_t) - ((uintptr_t)scratch % sizeof(uint32_t))) % sizeof(uint32_t);
+	unsigned long needed = padding + (unsigned long)maxDepth * sizeof(uint32_t) + maxStringLength + 1;
+	if(scratch == NULL || needed > scratchSize) {
+		return false;
+	}
+	releaseCarry();
+	this->maxStringLength = maxStringLength;
+	this->maxDepth = maxDepth;
+	this->maxItems = maxItems;
+	this->remaining = (uint32_t *)(scratch + padding);
+	this->stringArea = scratch + padding + maxDepth * sizeof(uint32_t);
+	this->limited = true;
+	depth = 0;
+	itemCount = 0;
+	return true;
 }
 
-CborReader::CborReader(CborInput &input, CborListener &listener) {
-	this->input = &input;
-	this->listener = &listener;
-	this->state = STATE_TYPE;
+void CborReader::Fail(const char *error) {
+	state = STATE_ERROR;
+	listener->OnError(error);
 }
 
+// Every item header except tags takes one slot from the innermost open container
+bool CborReader::BeginItem(bool isTag) {
+	if(++itemCount > maxItems) {
+		Fail("too many items");
+		return false;
+	}
+	if(isTag) {
+		return true;
+	}
+	while(depth > 0 && remaining[depth - 1] == 0) {
+		depth--;
+	}
+	if(depth > 0) {
+		remaining[depth - 1]--;
+	}
+	return true;
+}
 
-CborReader::~CborReader() {}
+// Rejects containers that can't possibly fit in the item budget up front
+bool CborReader::BeginContainer(uint32_t items) {
+	if(!limited || items == 0) {
+		return true;
+	}
+	if(items > maxItems - itemCount) {
+		Fail("too many items");
+		return false;
+	}
+	if(depth >= maxDepth) {
+		Fail("nesting too deep");
+		return false;
+	}
+	remaining[depth++] = items;
+	return true;
+}
+
+void CborReader::BeginArray(uint32_t size) {
+	if(BeginContainer(size)) {
+		listener->OnArray(size);
+	}
+}
 
+void CborReader::BeginMap(uint32_t size) {
+	if(size > 0x7FFFFFFF) {
+		Fail("too many items");
+	} else if(BeginContainer(2 * size)) {
+		listener->OnMap(size);
+	}
+}
 
 void CborReader::SetListener(CborListener &listener) {
 	this->listener = &listener;
@@ -72,6 +179,10 @@ void CborReader::Run() {
 				unsigned char majorType = type >> 5;
 				unsigned char minorType = type & 31;
 
+				if(limited && !BeginItem(majorType == 6)) {
+					break;
+				}
+
 				switch(majorType) {
 					case 0: // positive integer
 						if(minorType < 24) {
@@ -157,7 +268,7 @@ void CborReader::Run() {
 						break;
 					case 4: // array
 						if(minorType < 24) {
-							listener->OnArray(minorType);
+							BeginArray(minorType);
 						} else if(minorType == 24) {
 							state = STATE_ARRAY;
 							currentLength = 1;
@@ -177,7 +288,7 @@ void CborReader::Run() {
 						break;
 					case 5: // map
 						if(minorType < 24) {
-							listener->OnMap(minorType);
+							BeginMap(minorType);
 						} else if(minorType == 24) {
 							state = STATE_MAP;
 							currentLength = 1;
@@ -267,19 +378,17 @@ void CborReader::Run() {
 			if(input->hasBytes(currentLength)) {
 				switch(currentLength) {
 					case 1:
-						listener->OnInteger(-(int32_t)input->getByte());
+						listener->OnInteger(-1 - (int32_t)input->getByte());
 						state = STATE_TYPE;
 						break;
 					case 2:
-						listener->OnInteger(-(int32_t)input->getShort());
+						listener->OnInteger(-1 - (int32_t)input->getShort());
 						state = STATE_TYPE;
 						break;
 					case 4:
 						temp = input->getInt();
 						if(temp <= _INT_MAX) {
-							listener->OnInteger(-(int32_t) temp);
-						} else if(temp == 2147483648u) {
-							listener->OnInteger(_INT_MIN);
+							listener->OnInteger(-1 - (int32_t) temp);
 						} else {
 							listener->OnExtraInteger(temp, -1);
 						}
@@ -287,6 +396,7 @@ void CborReader::Run() {
 						break;
 					case 8:
 						listener->OnExtraInteger(input->getLong(), -1);
+						state = STATE_TYPE;
 						break;
 				}
 			} else break;
@@ -312,9 +422,17 @@ void CborReader::Run() {
 				}
 			} else break;
 		} else if(state == STATE_BYTES_DATA) {
-			if(input->hasBytes(currentLength)) {
-				unsigned char *data = new unsigned char[currentLength];
-				input->getBytes(data, currentLength);
+			if(limited && currentLength > maxStringLength) {
+				Fail("string too long");
+			} else if(input->hasBytes(currentLength)) {
+				unsigned char *data;
+				if(limited) {
+					data = stringArea;
+					memmove(data, input->getPointer(currentLength), currentLength);
+				} else {
+					data = new unsigned char[currentLength];
+					input->getBytes(data, currentLength);
+				}
 				state = STATE_TYPE;
 				listener->OnBytes(data, currentLength);
 			} else break;
@@ -340,29 +458,36 @@ void CborReader::Run() {
 				}
 			} else break;
 		} else if(state == STATE_STRING_DATA) {
-			if(input->hasBytes(currentLength)) {
-				unsigned char data[currentLength];
-				//Serial.print("currentLength:");
-				//Serial.println(currentLength);
-				input->getBytes(data, currentLength);
-				state = STATE_TYPE;
-				String str = (const char *) data;
-				listener->OnString(str);
-				str = "";
+			if(limited && currentLength > maxStringLength) {
+				Fail("string too long");
+			} else if(input->hasBytes(currentLength)) {
+				if(limited) {
+					memmove(stringArea, input->getPointer(currentLength), currentLength);
+					stringArea[currentLength] = 0;
+					state = STATE_TYPE;
+					listener->OnStringData((const char *) stringArea, currentLength);
+				} else {
+					unsigned char data[currentLength + 1];
+					input->getBytes(data, currentLength);
+					data[currentLength] = 0;
+					state = STATE_TYPE;
+					listener->OnStringData((const char *) data, currentLength);
+				}
 			} else break;
 		} else if(state == STATE_ARRAY) {
 			if(input->hasBytes(currentLength)) {
 				switch(currentLength) {
 					case 1:
-						listener->OnArray(input->getByte());
+						BeginArray(input->getByte());
 						state = STATE_TYPE;
 						break;
 					case 2:
-						listener->OnArray(currentLength = input->getShort());
+						currentLength = input->getShort();
+						BeginArray(currentLength);
 						state = STATE_TYPE;
 						break;
 					case 4:
-						listener->OnArray(input->getInt());
+						BeginArray(input->getInt());
 						state = STATE_TYPE;
 						break;
 					case 8:
@@ -375,15 +500,16 @@ void CborReader::Run() {
 			if(input->hasBytes(currentLength)) {
 				switch(currentLength) {
 					case 1:
-						listener->OnMap(input->getByte());
+						BeginMap(input->getByte());
 						state = STATE_TYPE;
 						break;
 					case 2:
-						listener->OnMap(currentLength = input->getShort());
+						currentLength = input->getShort();
+						BeginMap(currentLength);
 						state = STATE_TYPE;
 						break;
 					case 4:
-						listener->OnMap(input->getInt());
+						BeginMap(input->getInt());
 						state = STATE_TYPE;
 						break;
 					case 8:
@@ -421,16 +547,22 @@ void CborReader::Run() {
 						state = STATE_TYPE;
 						break;
 					case 2:
-						listener->OnSpecial(input->getShort());
+						listener->floatBits = input->getShort();
+						listener->floatSize = 2;
 						state = STATE_TYPE;
+						listener->OnFloat(cborHalfToDouble(listener->floatBits));
 						break;
 					case 4:
-						listener->OnSpecial(input->getInt());
+						listener->floatBits = input->getInt();
+						listener->floatSize = 4;
 						state = STATE_TYPE;
+						listener->OnFloat(cborBitsToFloat(listener->floatBits));
 						break;
 					case 8:
-						listener->OnExtraSpecial(input->getLong());
+						listener->floatBits = input->getLong();
+						listener->floatSize = 8;
 						state = STATE_TYPE;
+						listener->OnFloat(cborBitsToDouble(listener->floatBits));
 						break;
 				}
 			} else break;
@@ -442,444 +574,24 @@ void CborReader::Run() {
 	}
 }
 
-void CborReader::GetCborData(String &Cborpackage) {
-	uint32_t temp;
-	volatile char commaChar = ',';
-
-	while(1) {
-		if(state == STATE_TYPE) {
-			if(input->hasBytes(1)) {
-				unsigned char type = input->getByte();
-				unsigned char majorType = type >> 5;
-				unsigned char minorType = type & 31;
-				//Serial.write(majorType);
-				//Serial.println("minorType:" + minorType);
-
-				switch(majorType) {
-					case 0: // positive integer
-						if(minorType < 24) {
-							listener->OnInteger(minorType);
-							Cborpackage += minorType ;
-							Cborpackage += commaChar;
-						} else if(minorType == 24) { // 1 byte
-							currentLength = 1;
-							state = STATE_PINT;
-						} else if(minorType == 25) { // 2 byte
-							currentLength = 2;
-							state = STATE_PINT;
-						} else if(minorType == 26) { // 4 byte
-							currentLength = 4;
-							state = STATE_PINT;
-						} else if(minorType == 27) { // 8 byte
-							currentLength = 8;
-							state = STATE_PINT;
-						} else {
-							state = STATE_ERROR;
-							listener->OnError("invalid integer type");
-						}
-						break;
-					case 1: // negative integer
-						if(minorType < 24) {
-							listener->OnInteger(-1 - minorType);
-							Cborpackage += -1 -minorType ;
-							Cborpackage += commaChar;
-
-						} else if(minorType == 24) { // 1 byte
-							currentLength = 1;
-							state = STATE_NINT;
-						} else if(minorType == 25) { // 2 byte
-							currentLength = 2;
-							state = STATE_NINT;
-						} else if(minorType == 26) { // 4 byte
-							currentLength = 4;
-							state = STATE_NINT;
-						} else if(minorType == 27) { // 8 byte
-							currentLength = 8;
-							state = STATE_NINT;
-						} else {
-							state = STATE_ERROR;
-							listener->OnError("invalid integer type");
-						}
-						break;
-					case 2: // bytes
-						if(minorType < 24) {
-							state = STATE_BYTES_DATA;
-							currentLength = minorType;
-						} else if(minorType == 24) {
-							state = STATE_BYTES_SIZE;
-							currentLength = 1;
-						} else if(minorType == 25) { // 2 byte
-							currentLength = 2;
-							state = STATE_BYTES_SIZE;
-						} else if(minorType == 26) { // 4 byte
-							currentLength = 4;
-							state = STATE_BYTES_SIZE;
-						} else if(minorType == 27) { // 8 byte
-							currentLength = 8;
-							state = STATE_BYTES_SIZE;
-						} else {
-							state = STATE_ERROR;
-							listener->OnError("invalid bytes type");
-						}
-						break;
-					case 3: // string
-						if(minorType < 24) {
-							state = STATE_STRING_DATA;
-							currentLength = minorType;
-						} else if(minorType == 24) {
-							state = STATE_STRING_SIZE;
-							currentLength = 1;
-						} else if(minorType == 25) { // 2 byte
-							currentLength = 2;
-							state = STATE_STRING_SIZE;
-						} else if(minorType == 26) { // 4 byte
-							currentLength = 4;
-							state = STATE_STRING_SIZE;
-						} else if(minorType == 27) { // 8 byte
-							currentLength = 8;
-							state = STATE_STRING_SIZE;
-						} else {
-							state = STATE_ERROR;
-							listener->OnError("invalid string type");
-						}
-						break;
-					case 4: // array
-						if(minorType < 24) {
-							listener->OnArray(minorType);
-						} else if(minorType == 24) {
-							state = STATE_ARRAY;
-							currentLength = 1;
-						} else if(minorType == 25) { // 2 byte
-							currentLength = 2;
-							state = STATE_ARRAY;
-						} else if(minorType == 26) { // 4 byte
-							currentLength = 4;
-							state = STATE_ARRAY;
-						} else if(minorType == 27) { // 8 byte
-							currentLength = 8;
-							state = STATE_ARRAY;
-						} else {
-							state = STATE_ERROR;
-							listener->OnError("invalid array type");
-						}
-						break;
-					case 5: // map
-						if(minorType < 24) {
-							listener->OnMap(minorType);
-						} else if(minorType == 24) {
-							state = STATE_MAP;
-							currentLength = 1;
-						} else if(minorType == 25) { // 2 byte
-							currentLength = 2;
-							state = STATE_MAP;
-						} else if(minorType == 26) { // 4 byte
-							currentLength = 4;
-							state = STATE_MAP;
-						} else if(minorType == 27) { // 8 byte
-							currentLength = 8;
-							state = STATE_MAP;
-						} else {
-							state = STATE_ERROR;
-							listener->OnError("invalid array type");
-						}
-						break;
-					case 6: // tag
-						if(minorType < 24) {
-							listener->OnTag(minorType);
-						} else if(minorType == 24) {
-							state = STATE_TAG;
-							currentLength = 1;
-						} else if(minorType == 25) { // 2 byte
-							currentLength = 2;
-							state = STATE_TAG;
-						} else if(minorType == 26) { // 4 byte
-							currentLength = 4;
-							state = STATE_TAG;
-						} else if(minorType == 27) { // 8 byte
-							currentLength = 8;
-							state = STATE_TAG;
-						} else {
-							state = STATE_ERROR;
-							listener->OnError("invalid tag type");
-						}
-						break;
-					case 7: // special
-						if(minorType < 24) {
-							listener->OnSpecial(minorType);
-							Serial.print("h");
-						} else if(minorType == 24) {
-							state = STATE_SPECIAL;
-							currentLength = 1;
-						} else if(minorType == 25) { // 2 byte
-							currentLength = 2;
-							state = STATE_SPECIAL;
-						} else if(minorType == 26) { // 4 byte
-							currentLength = 4;
-							state = STATE_SPECIAL;
-						} else if(minorType == 27) { // 8 byte
-							currentLength = 8;
-							state = STATE_SPECIAL;
-						} else {
-							state = STATE_ERROR;
-							listener->OnError("invalid special type");
-						}
-						break;
-				}
-			} else break;
-		} else if(state == STATE_PINT) {
-			if(input->hasBytes(currentLength)) {
-				switch(currentLength) {
-					case 1:
-						temp =(int32_t) input->getByte();
-						listener->OnInteger(temp);
-						Cborpackage += temp;
-						Cborpackage += commaChar;
-						state = STATE_TYPE;
-						break;
-					case 2:
-						temp =(int32_t) input->getShort();
-						listener->OnInteger(temp);
-						Cborpackage += temp;
-						Cborpackage += commaChar;
-						state = STATE_TYPE;
-						break;
-					case 4:
-						temp =(int32_t) input->getInt();
-						if(temp <= _INT_MAX) {
-							listener->OnInteger(temp);
-							Cborpackage += temp;
-							Cborpackage += commaChar;
-
-						} else {
-
-							listener->OnExtraInteger(temp, 1);
-							Cborpackage += temp ;
-							Cborpackage += commaChar;
-
-						}
-						state = STATE_TYPE;
-						break;
-					case 8:
-						temp =(int32_t) input->getLong();
-						listener->OnExtraInteger(temp, 1);
-
-						Cborpackage += temp ;
-						Cborpackage += commaChar;
-						state = STATE_TYPE;
-						break;
-				}
-			} else break;
-		} else if(state == STATE_NINT) {
-			if(input->hasBytes(currentLength)) {
-				switch(currentLength) {
-					case 1:
-						listener->OnInteger(-(int32_t)input->getByte());
-						Cborpackage +=  (int32_t) input->getByte() ;
-						Cborpackage += commaChar;
-						Serial.print("h");
-
-						state = STATE_TYPE;
-						break;
-					case 2:
-						listener->OnInteger(-(int32_t)input->getShort());
-						Cborpackage +=  (int32_t) input->getShort();
-						Cborpackage += commaChar;
-						Serial.print("h");
-
-						state = STATE_TYPE;
-						break;
-					case 4:
-						temp = input->getInt();
-						if(temp <= _INT_MAX) {
-							listener->OnInteger(-(int32_t) temp);
-							Cborpackage += (int32_t) temp ;
-
-						Serial.print("h");
-							Cborpackage += commaChar;
-						} else if(temp == 2147483648u) {
-							listener->OnInteger(_INT_MIN);
-							Serial.print("h");
-
-							Cborpackage += _INT_MIN ;
-							Cborpackage += commaChar;
-						} else {
-							listener->OnExtraInteger(temp, -1);
-						}
-						state = STATE_TYPE;
-						break;
-					case 8:
-						listener->OnExtraInteger(input->getLong(), -1);
-						Serial.print("h");
-						//Cborpackage += input->getLong() ;
-						Cborpackage += commaChar;
-
-						break;
-				}
-			} else break;
-		} else if(state == STATE_BYTES_SIZE) {
-			if(input->hasBytes(currentLength)) {
-				switch(currentLength) {
-					case 1:
-						currentLength = input->getByte();
-						state = STATE_BYTES_DATA;
-						break;
-					case 2:
-						currentLength = input->getShort();
-						state = STATE_BYTES_DATA;
-						break;
-					case 4:
-						currentLength = input->getInt();
-						state = STATE_BYTES_DATA;
-						break;
-					case 8:
-						state = STATE_ERROR;
-						listener->OnError("extra long bytes");
-						break;
-				}
-			} else break;
-		} else if(state == STATE_BYTES_DATA) {
-			if(input->hasBytes(currentLength)) {
-				unsigned char *data = new unsigned char[currentLength];
-				input->getBytes(data, currentLength);
-				state = STATE_TYPE;
-				listener->OnBytes(data, currentLength);
-				Cborpackage +=  String(_INT_MIN, DEC) ;
-				Cborpackage += commaChar;
-			} else break;
-		} else if(state == STATE_STRING_SIZE) {
-			if(input->hasBytes(currentLength)) {
-				switch(currentLength) {
-					case 1:
-						currentLength = input->getByte();
-						state = STATE_STRING_DATA;
-						break;
-					case 2:
-						currentLength = input->getShort();
-						state = STATE_STRING_DATA;
-						break;
-					case 4:
-						currentLength = input->getInt();
-						state = STATE_STRING_DATA;
-						break;
-					case 8:
-						state = STATE_ERROR;
-						listener->OnError("extra long array");
-						break;
-				}
-			} else break;
-		} else if(state == STATE_STRING_DATA) {
-			if(input->hasBytes(currentLength)) {
-				unsigned char data[currentLength];
-				//Serial.print("currentLength:");
-				//Serial.println(currentLength);
-				input->getBytes(data, currentLength);
-				state = STATE_TYPE;
-				String str = (const char *) data;
-				Cborpackage +=  (const char *) data;
-				Cborpackage += commaChar;
-				listener->OnString(str);
-				str = "";
-			} else break;
-		} else if(state == STATE_ARRAY) {
-			if(input->hasBytes(currentLength)) {
-				switch(currentLength) {
-					case 1:
-						listener->OnArray(input->getByte());
-						state = STATE_TYPE;
-						break;
-					case 2:
-						listener->OnArray(currentLength = input->getShort());
-						state = STATE_TYPE;
-						break;
-					case 4:
-						listener->OnArray(input->getInt());
-						state = STATE_TYPE;
-						break;
-					case 8:
-						state = STATE_ERROR;
-						listener->OnError("extra long array");
-						break;
-				}
-			} else break;
-		} else if(state == STATE_MAP) {
-			if(input->hasBytes(currentLength)) {
-				switch(currentLength) {
-					case 1:
-						listener->OnMap(input->getByte());
-						state = STATE_TYPE;
-						break;
-					case 2:
-						listener->OnMap(currentLength = input->getShort());
-						state = STATE_TYPE;
-						break;
-					case 4:
-						listener->OnMap(input->getInt());
-						state = STATE_TYPE;
-						break;
-					case 8:
-						state = STATE_ERROR;
-						listener->OnError("extra long map");
-						break;
-				}
-			} else break;
-		} else if(state == STATE_TAG) {
-			if(input->hasBytes(currentLength)) {
-				switch(currentLength) {
-					case 1:
-						listener->OnTag(input->getByte());
-						state = STATE_TYPE;
-						break;
-					case 2:
-						listener->OnTag(input->getShort());
-						state = STATE_TYPE;
-						break;
-					case 4:
-						listener->OnTag(input->getInt());
-						state = STATE_TYPE;
-						break;
-					case 8:
-						listener->OnExtraTag(input->getLong());
-						state = STATE_TYPE;
-						break;
-				}
-			} else break;
-		} else if(state == STATE_SPECIAL) {
-			if (input->hasBytes(currentLength)) {
-				switch (currentLength) {
-					case 1:
-						listener->OnSpecial(input->getByte());
-						state = STATE_TYPE;
-						break;
-					case 2:
-						listener->OnSpecial(input->getShort());
-						state = STATE_TYPE;
-						break;
-					case 4:
-						listener->OnSpecial(input->getInt());
-						state = STATE_TYPE;
-						break;
-					case 8:
-						listener->OnExtraSpecial(input->getLong());
-						state = STATE_TYPE;
-						break;
-				}
-			} else break;
-		} else if(state == STATE_ERROR) {
-			break;
-		} else {
-			Serial.print("UNKNOWN STATE");
-		}
+void CborListener::OnFloat(double value) {
+	if(floatSize == 8) {
+		OnExtraSpecial(floatBits);
+	} else {
+		OnSpecial(floatBits);
 	}
 }
 
+void CborListener::OnStringData(const char *data, unsigned int size) {
+	String str = data;
+	OnString(str);
+}
 
 // TEST HANDLERS
 
 void CborDebugListener::OnInteger(int32_t value) {
 	Serial.print("integer:");
 	Serial.println(value);
-	//Cborpackage +=  value;
-	//Cborpackage += commaChar;
 }
 
 void CborDebugListener::OnBytes(unsigned char *data, unsigned int size) {
@@ -914,6 +626,11 @@ void CborDebugListener::OnSpecial(uint32_t code) {
 	Serial.println("special" + code);
 }
 
+void CborDebugListener::OnFloat(double value) {
+	Serial.print("float:");
+	Serial.println(value, 6);
+}
+
 void CborDebugListener::OnError(const char *error) {
 	Serial.print("error:");
 
@@ -2,9 +2,16 @@
 #define CBORDE_H
 
 #include "Arduino.h"
+#include "CborParser.h"
 
-#define _INT_MAX 2
-#define _INT_MIN 2
+// Longest string or byte string Feed() holds on to while it waits for the
+// rest of it, unless SetLimits() gave it scratch to use instead
+#ifndef CBOR_READER_MAX_CARRY
+#define CBOR_READER_MAX_CARRY 512
+#endif
+
+#define _INT_MAX 2147483647
+#define _INT_MIN (-2147483647 - 1)
 
 
 typedef enum {
@@ -22,40 +29,29 @@ typedef enum {
     STATE_ERROR
 } CborReaderState;
 
-class CborInput {
-	
-public:
-	CborInput(void *data, int size);
-	~CborInput();
-
-	bool hasBytes(unsigned int count);
-	unsigned char getByte();
-	unsigned short getShort();
-	uint32_t getInt();
-	uint64_t getLong();
-	void getBytes(void *to, int count);
-private:
-	unsigned char *data;
-	int size;
-	int offset;
-};
-
-
-
-
 class CborListener {
 public:
 	virtual void OnInteger(int32_t value) = 0;
 	virtual void OnBytes(unsigned char *data, unsigned int size) = 0;
 	virtual void OnString(String &str) = 0;
+	// Terminated text, valid only during the call; wraps it in a String by default
+	virtual void OnStringData(const char *data, unsigned int size);
 	virtual void OnArray(unsigned int size) = 0;
 	virtual void OnMap(unsigned int size) = 0;
 	virtual void OnTag(uint32_t tag) = 0;
 	virtual void OnSpecial(uint32_t code) = 0;
 	virtual void OnError(const char *error) = 0;
+	// Half, single and double precision floats. Unless it's overridden, the
+	// raw bits go to OnSpecial (half and single) or OnExtraSpecial (double)
+	// as they always have.
+	virtual void OnFloat(double value);
     virtual void OnExtraInteger(uint64_t value, int sign) {}
     virtual void OnExtraTag(uint64_t tag) {}
     virtual void OnExtraSpecial(uint64_t tag) {}
+private:
+	friend class CborReader;
+	uint64_t floatBits;
+	unsigned char floatSize;
 };
 
 class CborDebugListener : public CborListener {
@@ -68,6 +64,7 @@ public:
 	virtual void OnTag(uint32_t tag);
 	virtual void OnSpecial(uint32_t code);
 	virtual void OnError(const char *error);
+	virtual void OnFloat(double value);
 
     virtual void OnExtraInteger(uint64_t value, int sign);
     virtual void OnExtraTag(uint64_t tag);
@@ -78,15 +75,49 @@ class CborReader {
 public:
 	CborReader(CborInput &input);
 	CborReader(CborInput &input, CborListener &listener);
+	CborReader(CborListener &listener);
 	~CborReader();
 	void Run();
 	void SetListener(CborListener &listener);
-	void GetCborData(String &Cborpackage);
+
+	// Incremental decoding: items split across chunks are completed by the
+	// next Feed() call. Reset() drops any partial item before a new message.
+	// A split string longer than CBOR_READER_MAX_CARRY fails through OnError.
+	void Feed(const unsigned char *data, unsigned int size);
+	void Reset();
+
+	// Validating mode: strings and byte strings longer than maxStringLength,
+	// nesting deeper than maxDepth and messages with more than maxItems items
+	// are rejected through OnError before any of it is read. Strings and
+	// byte strings are then only held in scratch, so OnBytes data must not
+	// be deleted and is only valid during the call. Returns false if scratch
+	// can't fit maxDepth levels plus a maxStringLength string.
+	bool SetLimits(unsigned int maxStringLength, unsigned int maxDepth, unsigned long maxItems,
+		unsigned char *scratch, unsigned int scratchSize);
 private:
 	CborListener *listener;
 	CborInput *input;
 	CborReaderState state;
 	unsigned int currentLength;
+
+	bool limited = false;
+	unsigned int maxStringLength;
+	unsigned int maxDepth;
+	unsigned long maxItems;
+	uint32_t *remaining;
+	unsigned char *stringArea;
+	unsigned int depth = 0;
+	unsigned long itemCount = 0;
+	bool BeginItem(bool isTag);
+	void BeginArray(uint32_t size);
+	void BeginMap(uint32_t size);
+	bool BeginContainer(uint32_t items);
+	void Fail(const char *error);
+
+	unsigned char carryHeader[8];
+	unsigned char *carry = NULL;
+	unsigned int carryCount = 0;
+	void releaseCarry();
 };
 
 
@@ -23,20 +23,39 @@ CborStaticOutput::~CborStaticOutput() {
     }
 }
 
+void CborStaticOutput::reset() {
+	offset = 0;
+	overflowed = false;
+}
+
+bool CborStaticOutput::hasOverflowed() {
+	return overflowed;
+}
+
+void CborStaticOutput::rewind(unsigned int size) {
+	if (size < offset) {
+		offset = size;
+	}
+	overflowed = false;
+}
+
 void CborStaticOutput::putByte(unsigned char value) {
 	if(offset < capacity) {
 		buffer[offset++] = value;
 	} else {
-        // err
+		overflowed = true;
 	}
 }
 
 void CborStaticOutput::putBytes(const unsigned char *data, const unsigned int size) {
-	if(offset + size - 1 < capacity) {
-		memcpy(buffer + offset, data, size);
+	// offset never passes capacity, so this can't wrap, not even for size 0
+	if(size <= capacity - offset) {
+		if(size > 0) {
+			memcpy(buffer + offset, data, size);
+		}
 		offset += size;
 	} else {
-        // err
+		overflowed = true;
 	}
 }
 
@@ -56,6 +75,62 @@ unsigned int CborStaticOutput::getSize() {
 	return offset;
 }
 
+unsigned char *CborCountingOutput::getData() {
+	return NULL;
+}
+
+unsigned int CborCountingOutput::getSize() {
+	return size;
+}
+
+void CborCountingOutput::putByte(unsigned char value) {
+	size++;
+}
+
+void CborCountingOutput::putBytes(const unsigned char *data, const unsigned int size) {
+	this->size += size;
+}
+
+CborPrintOutput::CborPrintOutput(Print &out) {
+	this->out = &out;
+}
+
+unsigned char *CborPrintOutput::getData() {
+	return NULL;
+}
+
+unsigned int CborPrintOutput::getSize() {
+	return size;
+}
+
+void CborPrintOutput::putByte(unsigned char value) {
+	if(used == CBOR_PRINT_CHUNK) {
+		flush();
+	}
+	chunk[used++] = value;
+}
+
+// Long strings go out directly, without passing through the chunk
+void CborPrintOutput::putBytes(const unsigned char *data, const unsigned int size) {
+	if(size > CBOR_PRINT_CHUNK - used) {
+		flush();
+	}
+	if(size >= CBOR_PRINT_CHUNK) {
+		this->size += out->write(data, size);
+		return;
+	}
+	memcpy(chunk + used, data, size);
+	used += size;
+}
+
+unsigned int CborPrintOutput::flush() {
+	if(used > 0) {
+		size += out->write(chunk, used);
+		used = 0;
+	}
+	return size;
+}
+
 CborDynamicOutput::CborDynamicOutput() {
 	init(256);
 }
@@ -133,6 +208,7 @@ void CborWriter::writeTypeAndValue(uint8_t majorType, const uint64_t value) {
 	} else if(value < 65536ULL) {
 		output->putByte(majorType | 25);
 		output->putByte(value >> 8);
+		output->putByte(value);
 	} else if(value < 4294967296ULL) {
 		output->putByte(majorType | 26);
 		output->putByte(value >> 24);
@@ -155,8 +231,7 @@ void CborWriter::writeTypeAndValue(uint8_t majorType, const uint64_t value) {
 // UNCOMMENT FOR MKR1010
 #if defined(ARDUINO_SAMD_MKRWIFI1010)
 void CborWriter::writeInt(const int value) {
-	// This will break on 64-bit platforms
-	writeTypeAndValue(0, (uint32_t)value);
+	writeInt((int32_t)value);
 }
 #endif
 
@@ -199,6 +274,11 @@ void CborWriter::writeString(const String str) {
 	output->putBytes((const unsigned char *)str.c_str(), str.length());
 }
 
+void CborWriter::writeString(const CborKey &key) {
+	output->putBytes(key.header, key.headerSize);
+	output->putBytes((const unsigned char *)key.name, key.length);
+}
+
 void CborWriter::writeArray(const unsigned int size) {
 	writeTypeAndValue(4, (uint32_t)size);
 }
@@ -234,3 +314,87 @@ void CborWriter::writeDouble(double value) {
         output->putByte(arr[i]);
     }
 }
+
+// Carries the scale along, so the receiver doesn't need the Quantization
+void CborWriter::writeQuantized(float value, const Quantization &quantization) {
+    int32_t quantized = quantization.quantize(value);
+    if (!quantization.isDecimal()) {
+        writeFloat(quantization.restore(quantized));
+        return;
+    }
+    int64_t mantissa = (int64_t)quantized + quantization.offsetSteps;
+    if (quantization.exponent != 0) {
+        // Decimal fraction, RFC 8949 section 3.4.4. Its tag, array and exponent
+        // take 3 bytes, so past a single byte mantissa a float is no bigger;
+        // that's used whenever it still restores to the same step.
+        float restored = quantization.restore(quantized);
+        if ((mantissa < -24 || mantissa > 23) && quantization.quantize(restored) == quantized) {
+            writeFloat(restored);
+            return;
+        }
+        writeTag(4);
+        writeArray(2);
+        writeInt((int32_t)quantization.exponent);
+    }
+    writeInt(mantissa);
+}
+
+// Every multi-byte RFC 8746 tag has its little endian twin four numbers up,
+// so the array is tagged with the host byte order and copied as-is.
+void CborWriter::writeTypedArray(uint32_t bigEndianTag, const void *data, const unsigned int size) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	writeTag(bigEndianTag + 4);
+#else
+	writeTag(bigEndianTag);
+#endif
+	writeBytes((const unsigned char *)data, size);
+}
+
+void CborWriter::writeTypedArray(const uint8_t *data, const unsigned int count) {
+	writeTag(64);
+	writeBytes(data, count);
+}
+
+void CborWriter::writeTypedArray(const int8_t *data, const unsigned int count) {
+	writeTag(72);
+	writeBytes((const unsigned char *)data, count);
+}
+
+void CborWriter::writeTypedArray(const uint16_t *data, const unsigned int count) {
+	writeTypedArray(65, data, count * sizeof(uint16_t));
+}
+
+void CborWriter::writeTypedArray(const int16_t *data, const unsigned int count) {
+	writeTypedArray(73, data, count * sizeof(int16_t));
+}
+
+void CborWriter::writeTypedArray(const uint32_t *data, const unsigned int count) {
+	writeTypedArray(66, data, count * sizeof(uint32_t));
+}
+
+void CborWriter::writeTypedArray(const int32_t *data, const unsigned int count) {
+	writeTypedArray(74, data, count * sizeof(int32_t));
+}
+
+void CborWriter::writeTypedArray(const uint64_t *data, const unsigned int count) {
+	writeTypedArray(67, data, count * sizeof(uint64_t));
+}
+
+void CborWriter::writeTypedArray(const int64_t *data, const unsigned int count) {
+	writeTypedArray(75, data, count * sizeof(int64_t));
+}
+
+#if defined(ARDUINO_SAMD_MKRWIFI1010)
+void CborWriter::writeTypedArray(const int *data, const unsigned int count) {
+	writeTypedArray(74, data, count * sizeof(int));
+}
+#endif
+
+void CborWriter::writeTypedArray(const float *data, const unsigned int count) {
+	writeTypedArray(81, data, count * sizeof(float));
+}
+
+void CborWriter::writeTypedArray(const double *data, const unsigned int count) {
+	// AVR-style doubles are only 4 bytes wide
+	writeTypedArray(sizeof(double) == 8 ? 82 : 81, data, count * sizeof(double));
+}
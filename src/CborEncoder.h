@@ -19,6 +19,7 @@
 #define CBOREN_H
 
 #include "Arduino.h"
+#include "Quantization.h"
 
 class CborOutput {
 public:
@@ -33,6 +34,12 @@ public:
     CborStaticOutput(unsigned char *buffer, unsigned int capacity);
 	CborStaticOutput(unsigned int capacity);
 	~CborStaticOutput();
+	// Starts over at the beginning of the buffer
+	void reset();
+	// True if anything was dropped because it didn't fit since the last reset or rewind
+	bool hasOverflowed();
+	// Drops everything written after the first size bytes
+	void rewind(unsigned int size);
 	virtual unsigned char *getData();
 	virtual unsigned int getSize();
 	virtual void putByte(unsigned char value);
@@ -41,6 +48,7 @@ private:
 	unsigned char *buffer;
 	unsigned int capacity;
 	unsigned int offset;
+	bool overflowed = false;
     bool releaseBuffer;
 };
 
@@ -63,6 +71,95 @@ private:
     unsigned int offset;
 };
 
+// Only counts what would be written, to size a payload before encoding it
+class CborCountingOutput : public CborOutput {
+public:
+    virtual unsigned char *getData();
+    virtual unsigned int getSize();
+    virtual void putByte(unsigned char value);
+    virtual void putBytes(const unsigned char *data, const unsigned int size);
+private:
+    unsigned int size = 0;
+};
+
+// Writes through to a Print, e.g. an MQTT publish, in chunks of up to
+// CBOR_PRINT_CHUNK bytes instead of a write() per byte. Call flush() after
+// the last item; getSize() counts what out has accepted.
+#define CBOR_PRINT_CHUNK 32
+
+class CborPrintOutput : public CborOutput {
+public:
+    CborPrintOutput(Print &out);
+    virtual unsigned char *getData();
+    virtual unsigned int getSize();
+    virtual void putByte(unsigned char value);
+    virtual void putBytes(const unsigned char *data, const unsigned int size);
+    // Writes what's still buffered, and returns getSize()
+    unsigned int flush();
+private:
+    Print *out;
+    unsigned char chunk[CBOR_PRINT_CHUNK];
+    unsigned int used = 0;
+    unsigned int size = 0;
+};
+
+// Text string key whose CBOR header is worked out at compile time, e.g.
+//   constexpr CborKey temperature("temperature");
+// The name ends at its first NUL, so a char buffer holding a shorter name
+// works too, it's just measured at run time then.
+// A literal passed to set() directly is still written as a char *; declare
+// the key to get the precomputed header.
+class CborKey {
+public:
+    template<unsigned int N>
+    constexpr CborKey(const char (&name)[N]) : CborKey(name, measure(name, N - 1)) {
+        static_assert(N - 1 < 65536, "CborKey only encodes names shorter than 65536 bytes");
+    }
+
+    const char *name;
+    unsigned int length;
+    unsigned char header[3];
+    unsigned char headerSize;
+    // Same as CborAssetDictionary's, so a lookup doesn't have to hash the name again
+    uint32_t hash;
+
+    // Polynomial hash, split in halves so the compile time recursion stays shallow
+    static constexpr uint32_t hashName(const char *name, unsigned int length) {
+        return length == 0 ? 0
+            : length == 1 ? (unsigned char)name[0]
+            : hashName(name, length / 2) * power(length - length / 2)
+                + hashName(name + length / 2, length - length / 2);
+    }
+
+    // Offset of the first NUL in name, or length if there's none
+    static constexpr unsigned int measure(const char *name, unsigned int length) {
+        return length == 0 ? 0
+            : length == 1 ? (name[0] == 0 ? 0 : 1)
+            : measureRest(measure(name, length / 2), name, length);
+    }
+
+private:
+    constexpr CborKey(const char *name, unsigned int length)
+        : name(name), length(length),
+          header{
+              (unsigned char)(length < 24 ? 0x60 | length : (length < 256 ? 0x78 : 0x79)),
+              (unsigned char)(length < 24 ? 0 : (length < 256 ? length : length >> 8)),
+              (unsigned char)(length < 256 ? 0 : length & 0xFF)},
+          headerSize(length < 24 ? 1 : (length < 256 ? 2 : 3)),
+          hash(hashName(name, length)) {
+    }
+
+    static constexpr unsigned int measureRest(unsigned int first, const char *name, unsigned int length) {
+        return first < length / 2 ? first : length / 2 + measure(name + length / 2, length - length / 2);
+    }
+    static constexpr uint32_t power(unsigned int exponent) {
+        return exponent == 0 ? 1 : square(power(exponent / 2)) * (exponent & 1 ? 16777619u : 1u);
+    }
+    static constexpr uint32_t square(uint32_t value) {
+        return value * value;
+    }
+};
+
 class CborWriter {
 public:
 	CborWriter(CborOutput &output);
@@ -78,13 +175,31 @@ public:
 	void writeBytes(const unsigned char *data, const unsigned int size);
 	void writeString(const char *data, const unsigned int size);
 	void writeString(const String str);
+	void writeString(const CborKey &key);
 	void writeArray(const unsigned int size);
 	void writeMap(const unsigned int size);
 	void writeTag(const uint32_t tag);
 	void writeSpecial(const uint32_t special);
     void writeFloat(float value);
     void writeDouble(double value);
+    void writeQuantized(float value, const Quantization &quantization);
+
+    // RFC 8746 typed arrays, written in native byte order as one byte string
+    void writeTypedArray(const uint8_t *data, const unsigned int count);
+    void writeTypedArray(const int8_t *data, const unsigned int count);
+    void writeTypedArray(const uint16_t *data, const unsigned int count);
+    void writeTypedArray(const int16_t *data, const unsigned int count);
+    void writeTypedArray(const uint32_t *data, const unsigned int count);
+    void writeTypedArray(const int32_t *data, const unsigned int count);
+    void writeTypedArray(const uint64_t *data, const unsigned int count);
+    void writeTypedArray(const int64_t *data, const unsigned int count);
+    #if defined(ARDUINO_SAMD_MKRWIFI1010)
+    void writeTypedArray(const int *data, const unsigned int count);
+    #endif
+    void writeTypedArray(const float *data, const unsigned int count);
+    void writeTypedArray(const double *data, const unsigned int count);
 private:
+	void writeTypedArray(uint32_t bigEndianTag, const void *data, const unsigned int size);
 	void writeTypeAndValue(uint8_t majorType, const uint32_t value);
 	void writeTypeAndValue(uint8_t majorType, const uint64_t value);
 	CborOutput *output;
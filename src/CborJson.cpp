@@ -0,0 +1,524 @@
+#include "CborJson.h"
+#include <math.h>
+
+#define KIND_ARRAY 0
+#define KIND_MAP 1
+#define KIND_TAG 2
+
+CborJsonTranscoder::CborJsonTranscoder(Print &output, bool diagnostic) {
+    this->output = &output;
+    this->diagnostic = diagnostic;
+    this->error = NULL;
+    this->depth = 0;
+}
+
+const char *CborJsonTranscoder::getError() {
+    return error;
+}
+
+bool CborJsonTranscoder::fail(const char *error) {
+    this->error = error;
+    return false;
+}
+
+// Writes the next complete data item from input, false if it's malformed or cut short
+bool CborJsonTranscoder::transcode(CborInput &input) {
+    CborParser parser(input);
+    error = NULL;
+    depth = 0;
+
+    do {
+        if (!parser.next()) {
+            if (parser.type() == CBOR_TYPE_ERROR) {
+                return fail(parser.getError());
+            }
+            return fail("truncated item");
+        }
+        writeSeparator();
+        writeItem(parser);
+        if (error != NULL) {
+            return false;
+        }
+        closeCompleted();
+    } while (depth > 0);
+
+    return true;
+}
+
+// Also true inside a tag used as a key, as JSON drops the tag
+bool CborJsonTranscoder::isMapKey() {
+    int level = depth - 1;
+    if (level >= 0 && kinds[level] != KIND_TAG) {
+        return kinds[level] == KIND_MAP && indexes[level] % 2 == 0;
+    }
+    while (level >= 0 && kinds[level] == KIND_TAG) {
+        level--;
+    }
+    // The tag already counted for the map
+    return level >= 0 && kinds[level] == KIND_MAP && indexes[level] % 2 == 1;
+}
+
+void CborJsonTranscoder::writeSeparator() {
+    if (depth == 0) {
+        return;
+    }
+    unsigned char top = depth - 1;
+    if (kinds[top] == KIND_ARRAY && indexes[top] > 0) {
+        output->write(',');
+    } else if (kinds[top] == KIND_MAP && indexes[top] > 0) {
+        output->write(indexes[top] % 2 == 0 ? ',' : ':');
+    }
+}
+
+void CborJsonTranscoder::writeItem(CborParser &parser) {
+    // Map keys have to be strings in JSON
+    CborType type = parser.type();
+    bool key = !diagnostic && isMapKey();
+    if (key && (type == CBOR_TYPE_ARRAY || type == CBOR_TYPE_MAP)) {
+        fail("map key can't be written as JSON");
+        return;
+    }
+    bool quote = key && (type == CBOR_TYPE_INTEGER || type == CBOR_TYPE_FLOAT || type == CBOR_TYPE_SPECIAL);
+    if (quote) output->write('"');
+
+    // Containers start counting their own items; this one counts for the parent
+    if (depth > 0) {
+        indexes[depth - 1]++;
+    }
+
+    switch (parser.type()) {
+        case CBOR_TYPE_INTEGER:
+            writeInteger(parser);
+            break;
+        case CBOR_TYPE_STRING:
+            writeString(parser.asStringView());
+            break;
+        case CBOR_TYPE_BYTES:
+            writeBytes(parser.asStringView());
+            break;
+        case CBOR_TYPE_FLOAT:
+            writeFloat(parser.asFloat(), parser.isDoublePrecision());
+            break;
+        case CBOR_TYPE_SPECIAL:
+            writeSpecial(parser.asSpecial());
+            break;
+        case CBOR_TYPE_ARRAY:
+        case CBOR_TYPE_MAP:
+        case CBOR_TYPE_TAG:
+            if (depth == CBOR_JSON_MAX_DEPTH) {
+                fail("nesting too deep");
+                return;
+            }
+            if (parser.type() == CBOR_TYPE_ARRAY) {
+                output->write('[');
+                kinds[depth] = KIND_ARRAY;
+                totals[depth] = parser.asCount();
+            } else if (parser.type() == CBOR_TYPE_MAP) {
+                output->write('{');
+                kinds[depth] = KIND_MAP;
+                totals[depth] = 2 * (uint64_t)parser.asCount();
+            } else {
+                if (diagnostic) {
+                    writeUnsigned(parser.asTag());
+                    output->write('(');
+                }
+                kinds[depth] = KIND_TAG;
+                totals[depth] = 1;
+            }
+            indexes[depth] = 0;
+            depth++;
+            break;
+        default:
+            fail("unexpected item");
+            return;
+    }
+
+    if (quote) output->write('"');
+}
+
+void CborJsonTranscoder::closeCompleted() {
+    while (depth > 0 && indexes[depth - 1] == totals[depth - 1]) {
+        depth--;
+        if (kinds[depth] == KIND_ARRAY) {
+            output->write(']');
+        } else if (kinds[depth] == KIND_MAP) {
+            output->write('}');
+        } else if (diagnostic) {
+            output->write(')');
+        }
+    }
+}
+
+void CborJsonTranscoder::writeUnsigned(uint64_t value) {
+    char digits[21];
+    unsigned char position = sizeof(digits);
+    do {
+        digits[--position] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    output->write((const uint8_t *)digits + position, sizeof(digits) - position);
+}
+
+void CborJsonTranscoder::writeInteger(CborParser &parser) {
+    uint64_t value = parser.asUnsigned();
+    if (!parser.isNegative()) {
+        writeUnsigned(value);
+    } else if (value == 0xFFFFFFFFFFFFFFFFULL) {
+        output->print("-18446744073709551616");
+    } else {
+        output->write('-');
+        writeUnsigned(value + 1);
+    }
+}
+
+// Just enough of a big unsigned integer to print doubles exactly: the
+// largest number involved, around 2^1080, fits 36 limbs
+#define BIG_LIMBS 36
+
+struct BigNumber {
+    uint32_t limbs[BIG_LIMBS];
+    unsigned char size;
+};
+
+static void bigSet(BigNumber &number, uint64_t value) {
+    number.size = 0;
+    while (value > 0) {
+        number.limbs[number.size++] = (uint32_t)value;
+        value >>= 32;
+    }
+}
+
+static void bigMultiply(BigNumber &number, uint32_t factor) {
+    uint64_t carry = 0;
+    for (unsigned char i = 0; i < number.size; i++) {
+        carry += (uint64_t)number.limbs[i] * factor;
+        number.limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry > 0) {
+        number.limbs[number.size++] = (uint32_t)carry;
+    }
+}
+
+static void bigMultiplyPow10(BigNumber &number, unsigned int exponent) {
+    static const uint32_t powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    for (; exponent >= 9; exponent -= 9) {
+        bigMultiply(number, 1000000000);
+    }
+    bigMultiply(number, powers[exponent]);
+}
+
+static void bigShiftLeft(BigNumber &number, unsigned int bits) {
+    if (number.size == 0) {
+        return;
+    }
+    unsigned int words = bits / 32;
+    bits %= 32;
+    if (bits > 0) {
+        uint32_t carry = 0;
+        for (unsigned char i = 0; i < number.size; i++) {
+            uint32_t limb = number.limbs[i];
+            number.limbs[i] = (limb << bits) | carry;
+            carry = limb >> (32 - bits);
+        }
+        if (carry > 0) {
+            number.limbs[number.size++] = carry;
+        }
+    }
+    if (words > 0) {
+        memmove(number.limbs + words, number.limbs, number.size * sizeof(uint32_t));
+        memset(number.limbs, 0, words * sizeof(uint32_t));
+        number.size += words;
+    }
+}
+
+static int bigCompare(const BigNumber &a, const BigNumber &b) {
+    if (a.size != b.size) {
+        return a.size < b.size ? -1 : 1;
+    }
+    for (int i = a.size - 1; i >= 0; i--) {
+        if (a.limbs[i] != b.limbs[i]) {
+            return a.limbs[i] < b.limbs[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static void bigAdd(BigNumber &a, const BigNumber &b) {
+    uint64_t carry = 0;
+    unsigned char size = a.size > b.size ? a.size : b.size;
+    for (unsigned char i = 0; i < size; i++) {
+        carry += (uint64_t)(i < a.size ? a.limbs[i] : 0) + (i < b.size ? b.limbs[i] : 0);
+        a.limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    a.size = size;
+    if (carry > 0) {
+        a.limbs[a.size++] = (uint32_t)carry;
+    }
+}
+
+// a -= b, where b <= a
+static void bigSubtract(BigNumber &a, const BigNumber &b) {
+    int64_t borrow = 0;
+    for (unsigned char i = 0; i < a.size; i++) {
+        borrow += (int64_t)a.limbs[i] - (i < b.size ? b.limbs[i] : 0);
+        a.limbs[i] = (uint32_t)borrow;
+        borrow = borrow < 0 ? -1 : 0;
+    }
+    while (a.size > 0 && a.limbs[a.size - 1] == 0) {
+        a.size--;
+    }
+}
+
+// Writes the fewest digits that still read back as exactly value, in the
+// precision it was encoded with (Burger and Dybvig's free-format algorithm).
+// value is finite and positive; returns the digit count and sets exponent
+// to the power of ten of the first digit.
+static int shortestDigits(double value, bool doublePrecision, char *digits, int &exponent) {
+    int mantissaBits = doublePrecision ? 53 : 24;
+    int minExponent = doublePrecision ? -1074 : -149;
+    int binaryExponent;
+    uint64_t mantissa = (uint64_t)ldexp(frexp(value, &binaryExponent), mantissaBits);
+    binaryExponent -= mantissaBits;
+    if (binaryExponent < minExponent) {
+        mantissa >>= minExponent - binaryExponent;
+        binaryExponent = minExponent;
+    }
+
+    // value = r / s, and the values that read back the same lie within
+    // (r - lowMargin) / s and (r + highMargin) / s, bounds included if even
+    bool even = (mantissa & 1) == 0;
+    bool unequalMargins = mantissa == (1ULL << (mantissaBits - 1)) && binaryExponent > minExponent;
+    unsigned int shift = unequalMargins ? 2 : 1;
+    BigNumber r, s, lowMargin, high;
+    bigSet(r, mantissa);
+    bigSet(s, 1);
+    bigSet(lowMargin, 1);
+    if (binaryExponent >= 0) {
+        bigShiftLeft(r, binaryExponent + shift);
+        bigShiftLeft(s, shift);
+        bigShiftLeft(lowMargin, binaryExponent);
+    } else {
+        bigShiftLeft(r, shift);
+        bigShiftLeft(s, shift - binaryExponent);
+    }
+
+    int k = (int)ceil(log10(value) - 1e-10);
+    if (k >= 0) {
+        bigMultiplyPow10(s, k);
+    } else {
+        bigMultiplyPow10(r, -k);
+        bigMultiplyPow10(lowMargin, -k);
+    }
+
+    // The estimate of k can be one off either way
+    while (true) {
+        high = r;
+        bigAdd(high, lowMargin);
+        if (unequalMargins) bigAdd(high, lowMargin);
+        int compared = bigCompare(high, s);
+        if (even ? compared >= 0 : compared > 0) {
+            bigMultiply(s, 10);
+            k++;
+            continue;
+        }
+        bigMultiply(high, 10);
+        compared = bigCompare(high, s);
+        if (even ? compared < 0 : compared <= 0) {
+            bigMultiply(r, 10);
+            bigMultiply(lowMargin, 10);
+            k--;
+            continue;
+        }
+        break;
+    }
+
+    int count = 0;
+    int maxDigits = doublePrecision ? 17 : 9;
+    while (true) {
+        bigMultiply(r, 10);
+        bigMultiply(lowMargin, 10);
+        int digit = 0;
+        while (bigCompare(r, s) >= 0) {
+            bigSubtract(r, s);
+            digit++;
+        }
+        high = r;
+        bigAdd(high, lowMargin);
+        if (unequalMargins) bigAdd(high, lowMargin);
+        int lowCompared = bigCompare(r, lowMargin);
+        int highCompared = bigCompare(high, s);
+        bool low = even ? lowCompared <= 0 : lowCompared < 0;
+        bool up = even ? highCompared >= 0 : highCompared > 0;
+        if (!low && !up && count + 1 < maxDigits) {
+            digits[count++] = '0' + digit;
+            continue;
+        }
+        if (low == up) {
+            // Either way reads back right, so take the nearest
+            high = r;
+            bigShiftLeft(high, 1);
+            int compared = bigCompare(high, s);
+            if (compared > 0 || (compared == 0 && digit % 2 == 1)) digit++;
+        } else if (up) {
+            digit++;
+        }
+        digits[count++] = '0' + digit;
+        break;
+    }
+    exponent = k - 1;
+    return count;
+}
+
+// Prints the shortest digits that read back as the same float or double,
+// without relying on printf float support, which SAMD cores leave out.
+void CborJsonTranscoder::writeFloat(double value, bool doublePrecision) {
+    if (isnan(value)) {
+        output->print(diagnostic ? "NaN" : "null");
+        return;
+    }
+    if (isinf(value)) {
+        output->print(diagnostic ? (value < 0 ? "-Infinity" : "Infinity") : "null");
+        return;
+    }
+    if (signbit(value)) {
+        output->write('-');
+        value = -value;
+    }
+    if (value == 0) {
+        output->print("0.0");
+        return;
+    }
+    if (value < 1e15 && value == floor(value)) {
+        writeUnsigned((uint64_t)value);
+        output->print(".0");
+        return;
+    }
+
+    int precision = doublePrecision ? 17 : 9;
+    char digits[17];
+    int exponent;
+    int count = shortestDigits(value, doublePrecision, digits, exponent);
+
+    if (exponent >= -5 && exponent < precision) {
+        if (exponent < 0) {
+            output->print("0.");
+            for (int i = exponent + 1; i < 0; i++) output->write('0');
+            output->write((const uint8_t *)digits, count);
+        } else {
+            int whole = exponent + 1;
+            for (int i = 0; i < whole; i++) output->write(i < count ? digits[i] : '0');
+            output->write('.');
+            if (count > whole) {
+                output->write((const uint8_t *)digits + whole, count - whole);
+            } else {
+                output->write('0');
+            }
+        }
+    } else {
+        output->write(digits[0]);
+        output->write('.');
+        if (count > 1) {
+            output->write((const uint8_t *)digits + 1, count - 1);
+        } else {
+            output->write('0');
+        }
+        output->write('e');
+        if (exponent < 0) {
+            output->write('-');
+            exponent = -exponent;
+        }
+        writeUnsigned(exponent);
+    }
+}
+
+void CborJsonTranscoder::writeString(CborStringView str) {
+    static const char hex[] = "0123456789abcdef";
+    output->write('"');
+    unsigned int start = 0;
+    for (unsigned int i = 0; i < str.length; i++) {
+        unsigned char c = str.data[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // Copy the plain run in one go, then the escape
+        output->write((const uint8_t *)str.data + start, i - start);
+        start = i + 1;
+        output->write('\\');
+        if (c == '"' || c == '\\') {
+            output->write(c);
+        } else if (c == '\n') {
+            output->write('n');
+        } else if (c == '\r') {
+            output->write('r');
+        } else if (c == '\t') {
+            output->write('t');
+        } else {
+            output->print("u00");
+            output->write(hex[c >> 4]);
+            output->write(hex[c & 15]);
+        }
+    }
+    output->write((const uint8_t *)str.data + start, str.length - start);
+    output->write('"');
+}
+
+void CborJsonTranscoder::writeBytes(CborStringView bytes) {
+    const unsigned char *data = (const unsigned char *)bytes.data;
+    if (diagnostic) {
+        static const char hex[] = "0123456789abcdef";
+        output->print("h'");
+        for (unsigned int i = 0; i < bytes.length; i++) {
+            output->write(hex[data[i] >> 4]);
+            output->write(hex[data[i] & 15]);
+        }
+        output->write('\'');
+        return;
+    }
+
+    static const char base64url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    output->write('"');
+    unsigned int i = 0;
+    for (; i + 2 < bytes.length; i += 3) {
+        uint32_t group = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+        output->write(base64url[(group >> 18) & 63]);
+        output->write(base64url[(group >> 12) & 63]);
+        output->write(base64url[(group >> 6) & 63]);
+        output->write(base64url[group & 63]);
+    }
+    if (i < bytes.length) {
+        uint32_t group = (uint32_t)data[i] << 16;
+        if (i + 1 < bytes.length) group |= (uint32_t)data[i + 1] << 8;
+        output->write(base64url[(group >> 18) & 63]);
+        output->write(base64url[(group >> 12) & 63]);
+        if (i + 1 < bytes.length) output->write(base64url[(group >> 6) & 63]);
+    }
+    output->write('"');
+}
+
+void CborJsonTranscoder::writeSpecial(uint32_t code) {
+    switch (code) {
+        case 20:
+            output->print("false");
+            break;
+        case 21:
+            output->print("true");
+            break;
+        case 22:
+            output->print("null");
+            break;
+        case 23:
+            output->print(diagnostic ? "undefined" : "null");
+            break;
+        default:
+            if (diagnostic) {
+                output->print("simple(");
+                writeUnsigned(code);
+                output->write(')');
+            } else {
+                output->print("null");
+            }
+            break;
+    }
+}
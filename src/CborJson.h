@@ -0,0 +1,48 @@
+#ifndef CBOR_JSON_H_
+#define CBOR_JSON_H_
+
+#include "Arduino.h"
+#include "CborDecoder.h"
+
+#define CBOR_JSON_MAX_DEPTH 16
+
+// Transcodes one CBOR data item at a time into JSON, or into RFC 8949
+// diagnostic notation, written straight to any Print. Memory use is fixed:
+// only the nesting stack is kept, up to CBOR_JSON_MAX_DEPTH levels.
+//
+// JSON output follows RFC 8949 section 6.1: byte strings become base64url
+// strings, tags are dropped, number and simple value map keys are quoted and
+// values JSON can't express (NaN, infinities, undefined, other simple values)
+// are null. Array and map keys fail the transcode. Floats are written with
+// the fewest digits that read back as the same value.
+class CborJsonTranscoder {
+public:
+    CborJsonTranscoder(Print &output, bool diagnostic = false);
+
+    bool transcode(CborInput &input);
+    const char *getError();
+
+private:
+    Print *output;
+    bool diagnostic;
+    const char *error;
+
+    unsigned char depth;
+    unsigned char kinds[CBOR_JSON_MAX_DEPTH];
+    uint64_t totals[CBOR_JSON_MAX_DEPTH];
+    uint64_t indexes[CBOR_JSON_MAX_DEPTH];
+
+    bool fail(const char *error);
+    bool isMapKey();
+    void writeSeparator();
+    void writeItem(CborParser &parser);
+    void writeUnsigned(uint64_t value);
+    void writeInteger(CborParser &parser);
+    void writeFloat(double value, bool doublePrecision);
+    void writeString(CborStringView str);
+    void writeBytes(CborStringView bytes);
+    void writeSpecial(uint32_t code);
+    void closeCompleted();
+};
+
+#endif
@@ -0,0 +1,266 @@
+#include "CborParser.h"
+#include <math.h>
+
+CborInput::CborInput(void *data, int size) {
+	this->data = (unsigned char *)data;
+	this->size = size;
+	this->offset = 0;
+}
+
+CborInput::~CborInput() {}
+
+
+bool CborInput::hasBytes(unsigned int count) {
+	return (unsigned int)(size - offset) >= count;
+}
+
+unsigned int CborInput::getRemaining() {
+	return size - offset;
+}
+
+unsigned char CborInput::getByte() {
+	return data[offset++];
+}
+
+unsigned short CborInput::getShort() {
+	unsigned short value = ((unsigned short)data[offset] << 8) | ((unsigned short)data[offset + 1]);
+	offset += 2;
+	return value;
+}
+
+uint32_t CborInput::getInt() {
+	uint32_t value = ((uint32_t)data[offset] << 24) | ((uint32_t)data[offset + 1] << 16) | ((uint32_t)data[offset + 2] << 8) | ((uint32_t)data[offset + 3]);
+	offset += 4;
+	return value;
+}
+
+uint64_t CborInput::getLong() {
+	uint64_t value = ((uint64_t)data[offset] << 56) | ((uint64_t)data[offset+1] << 48) | ((uint64_t)data[offset+2] << 40) | ((uint64_t)data[offset+3] << 32) | ((uint64_t)data[offset+4] << 24) | ((uint64_t)data[offset+5] << 16) | ((uint64_t)data[offset+6] << 8) | ((uint64_t)data[offset+7]);
+	offset += 8;
+	return value;
+}
+
+void CborInput::getBytes(void *to, int count) {
+	memcpy(to, data + offset, count);
+	offset += count;
+}
+
+
+const unsigned char *CborInput::getPointer(int count) {
+	const unsigned char *pointer = data + offset;
+	offset += count;
+	return pointer;
+}
+
+// Converts an IEEE 754 half precision value, as allowed by RFC 8949 Appendix D
+double cborHalfToDouble(uint16_t half) {
+	int exponent = (half >> 10) & 0x1f;
+	int mantissa = half & 0x3ff;
+	double value;
+	if (exponent == 0) {
+		value = ldexp(mantissa, -24);
+	} else if (exponent != 31) {
+		value = ldexp(mantissa + 1024, exponent - 25);
+	} else {
+		value = mantissa == 0 ? INFINITY : NAN;
+	}
+	return half & 0x8000 ? -value : value;
+}
+
+float cborBitsToFloat(uint32_t bits) {
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+double cborBitsToDouble(uint64_t bits) {
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Compares all length bytes, embedded zeros included
+bool CborStringView::equals(const char *str) {
+	return strlen(str) == length && memcmp(data, str, length) == 0;
+}
+
+CborParser::CborParser(CborInput &input) {
+	this->input = &input;
+	this->currentType = CBOR_TYPE_NONE;
+	this->value = 0;
+	this->negative = false;
+	this->floatValue = 0;
+	this->doublePrecision = false;
+	this->view.data = NULL;
+	this->view.length = 0;
+	this->error = NULL;
+}
+
+bool CborParser::fail(const char *error) {
+	this->error = error;
+	currentType = CBOR_TYPE_ERROR;
+	return false;
+}
+
+bool CborParser::next() {
+	if(currentType == CBOR_TYPE_ERROR) {
+		return false;
+	}
+	if(!input->hasBytes(1)) {
+		currentType = CBOR_TYPE_END;
+		return false;
+	}
+
+	unsigned char type = input->getByte();
+	unsigned char majorType = type >> 5;
+	unsigned char minorType = type & 31;
+
+	if(minorType < 24) {
+		value = minorType;
+	} else if(minorType == 24) {
+		if(!input->hasBytes(1)) return fail("truncated header");
+		value = input->getByte();
+	} else if(minorType == 25) {
+		if(!input->hasBytes(2)) return fail("truncated header");
+		value = input->getShort();
+	} else if(minorType == 26) {
+		if(!input->hasBytes(4)) return fail("truncated header");
+		value = input->getInt();
+	} else if(minorType == 27) {
+		if(!input->hasBytes(8)) return fail("truncated header");
+		value = input->getLong();
+	} else {
+		return fail("indefinite length items are not supported");
+	}
+
+	negative = false;
+	switch(majorType) {
+		case 0: // positive integer
+			currentType = CBOR_TYPE_INTEGER;
+			break;
+		case 1: // negative integer
+			currentType = CBOR_TYPE_INTEGER;
+			negative = true;
+			break;
+		case 2: // bytes
+		case 3: // string
+			if(value > 0x7fffffff || !input->hasBytes(value)) return fail("truncated string");
+			view.length = value;
+			view.data = (const char *)input->getPointer(value);
+			currentType = majorType == 2 ? CBOR_TYPE_BYTES : CBOR_TYPE_STRING;
+			break;
+		case 4: // array
+			// Every item takes at least a byte, so this also keeps asCount() exact
+			if(value > input->getRemaining()) return fail("truncated array");
+			currentType = CBOR_TYPE_ARRAY;
+			break;
+		case 5: // map
+			if(value > input->getRemaining() / 2) return fail("truncated map");
+			currentType = CBOR_TYPE_MAP;
+			break;
+		case 6: // tag
+			currentType = CBOR_TYPE_TAG;
+			break;
+		case 7: // special or float
+			doublePrecision = minorType == 27;
+			if(minorType == 25) {
+				floatValue = cborHalfToDouble(value);
+				currentType = CBOR_TYPE_FLOAT;
+			} else if(minorType == 26) {
+				floatValue = cborBitsToFloat(value);
+				currentType = CBOR_TYPE_FLOAT;
+			} else if(minorType == 27) {
+				floatValue = cborBitsToDouble(value);
+				currentType = CBOR_TYPE_FLOAT;
+			} else {
+				currentType = CBOR_TYPE_SPECIAL;
+			}
+			break;
+	}
+	return true;
+}
+
+// Moves past the current item, including everything nested in it. next()
+// has checked that a container's items can fit in the input, so pending
+// can't overflow.
+bool CborParser::skip() {
+	uint64_t pending = 0;
+	while(true) {
+		if(currentType == CBOR_TYPE_ARRAY) {
+			pending += value;
+		} else if(currentType == CBOR_TYPE_MAP) {
+			pending += 2 * value;
+		} else if(currentType == CBOR_TYPE_TAG) {
+			pending += 1;
+		} else if(currentType == CBOR_TYPE_ERROR || currentType == CBOR_TYPE_END) {
+			return false;
+		}
+		if(pending == 0) {
+			return true;
+		}
+		pending--;
+		if(!next()) {
+			return currentType == CBOR_TYPE_END ? fail("truncated container") : false;
+		}
+	}
+}
+
+CborType CborParser::type() {
+	return currentType;
+}
+
+// Saturates when the integer doesn't fit, see fitsInt()
+int64_t CborParser::asInt() {
+	if(!fitsInt()) {
+		return negative ? INT64_MIN : INT64_MAX;
+	}
+	return negative ? -1 - (int64_t)value : (int64_t)value;
+}
+
+// CBOR integers run from -2^64 to 2^64 - 1, int64_t only covers half of that
+bool CborParser::fitsInt() {
+	return value <= (uint64_t)INT64_MAX;
+}
+
+uint64_t CborParser::asUnsigned() {
+	return value;
+}
+
+bool CborParser::isNegative() {
+	return negative;
+}
+
+double CborParser::asFloat() {
+	if(currentType == CBOR_TYPE_INTEGER) {
+		return negative ? -1.0 - (double)value : (double)value;
+	}
+	return floatValue;
+}
+
+bool CborParser::isDoublePrecision() {
+	return doublePrecision;
+}
+
+bool CborParser::asBool() {
+	return currentType == CBOR_TYPE_SPECIAL && value == 21;
+}
+
+CborStringView CborParser::asStringView() {
+	return view;
+}
+
+unsigned int CborParser::asCount() {
+	return value;
+}
+
+uint64_t CborParser::asTag() {
+	return value;
+}
+
+uint32_t CborParser::asSpecial() {
+	return value;
+}
+
+const char *CborParser::getError() {
+	return error;
+}
@@ -0,0 +1,94 @@
+#ifndef CBOR_PARSER_H_
+#define CBOR_PARSER_H_
+
+// Doesn't depend on the Arduino core, so it also builds on a host
+#include <stdint.h>
+#include <string.h>
+
+class CborInput {
+	
+public:
+	CborInput(void *data, int size);
+	~CborInput();
+
+	bool hasBytes(unsigned int count);
+	unsigned char getByte();
+	unsigned short getShort();
+	uint32_t getInt();
+	uint64_t getLong();
+	void getBytes(void *to, int count);
+	const unsigned char *getPointer(int count);
+	unsigned int getRemaining();
+private:
+	unsigned char *data;
+	int size;
+	int offset;
+};
+
+typedef enum {
+	CBOR_TYPE_NONE,
+	CBOR_TYPE_INTEGER,
+	CBOR_TYPE_BYTES,
+	CBOR_TYPE_STRING,
+	CBOR_TYPE_ARRAY,
+	CBOR_TYPE_MAP,
+	CBOR_TYPE_TAG,
+	CBOR_TYPE_SPECIAL,
+	CBOR_TYPE_FLOAT,
+	CBOR_TYPE_END,
+	CBOR_TYPE_ERROR
+} CborType;
+
+// Points into the CborInput buffer, so it's only valid as long as that is.
+// Not null terminated.
+class CborStringView {
+public:
+	const char *data;
+	unsigned int length;
+
+	bool equals(const char *str);
+};
+
+// Pull parser: every next() moves to the following item, arrays and maps
+// included, without copying or allocating anything. Strings and byte
+// strings are handed out as views into the input buffer.
+class CborParser {
+public:
+	CborParser(CborInput &input);
+
+	bool next();
+	bool skip();
+	CborType type();
+
+	int64_t asInt();
+	bool fitsInt();
+	uint64_t asUnsigned();
+	bool isNegative();
+	double asFloat();
+	// Only for CBOR_TYPE_FLOAT: false for half and single precision
+	bool isDoublePrecision();
+	bool asBool();
+	CborStringView asStringView();
+	unsigned int asCount();
+	uint64_t asTag();
+	uint32_t asSpecial();
+
+	const char *getError();
+private:
+	CborInput *input;
+	CborType currentType;
+	uint64_t value;
+	bool negative;
+	double floatValue;
+	bool doublePrecision;
+	CborStringView view;
+	const char *error;
+
+	bool fail(const char *error);
+};
+
+double cborHalfToDouble(uint16_t half);
+float cborBitsToFloat(uint32_t bits);
+double cborBitsToDouble(uint64_t bits);
+
+#endif
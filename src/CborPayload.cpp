@@ -1,78 +1,220 @@
 #include <stdint.h>
 
 #include "CborPayload.h"
+#include "CborParser.h"
 #include "GeoLocation.h"
 
-CborPayload::CborPayload(unsigned int capacity) {
+// Room for the largest header: tag 120, an array of 3 and a map of up to
+// 65535 assets. The actual header is written right before the assets.
+static const unsigned int HEADER_SIZE = 6;
+static const unsigned int MAX_ASSETS = 65535;
+// Timestamp (tag, 64-bit integer) and location (tag, array, 3 floats)
+static const unsigned int MAX_FOOTER_SIZE = 28;
+
+CborPayload::CborPayload(unsigned int capacity)
+    : buffer(new unsigned char[capacity]), output(buffer, capacity), writer(output) {
+    this->capacity = capacity;
+    reset();
+}
+
+CborPayload::CborPayload(unsigned char *buffer, unsigned int capacity)
+    : buffer(buffer), output(buffer, capacity), writer(output) {
     this->capacity = capacity;
-    this->buffer = new unsigned char[capacity];
+    releaseBuffer = false;
     reset();
 }
 
 CborPayload::~CborPayload() {
-    delete[] buffer;
-    delete output;
-    delete writer;
+    if (releaseBuffer) {
+        delete[] buffer;
+    }
 }
 
 void CborPayload::reset() {
-    delete writer;
-    delete output;
-    output = new CborStaticOutput(buffer, capacity);
-    writer = new CborWriter(*output);
+    output.reset();
+    containerOpen = false;
     assetCount = 0;
+    hasTimestamp = false;
+    hasLocation = false;
+    hasDictionaryKeys = false;
 
     // We're always assuming the full IoT Data Point (Tag 120)
     // is going to be used. The real state will be represented
     // only in getBytes().
-    writer->writeTag(120);
-    writer->writeArray(1);
-    writer->writeMap(0);
+    for (unsigned int i = 0; i < HEADER_SIZE; i++) {
+        output.putByte(0);
+    }
+}
+
+// Assets found in the dictionary are keyed by integer instead of by name
+void CborPayload::setDictionary(CborAssetDictionary *dictionary) {
+    this->dictionary = dictionary;
+}
+
+CborAssetDictionary *CborPayload::getDictionary() {
+    return dictionary;
+}
+
+bool CborPayload::usesDictionaryKeys() {
+    return hasDictionaryKeys;
+}
+
+void CborPayload::writeAssetName(char *assetName) {
+    int key = dictionary ? dictionary->find(assetName) : -1;
+    if (key >= 0) {
+        writer.writeInt((uint32_t)key);
+        hasDictionaryKeys = true;
+    } else {
+        writer.writeString(assetName, strlen(assetName));
+    }
+}
+
+void CborPayload::writeAssetName(const CborKey &assetKey) {
+    int key = dictionary ? dictionary->find(assetKey) : -1;
+    if (key >= 0) {
+        writer.writeInt((uint32_t)key);
+        hasDictionaryKeys = true;
+    } else {
+        writer.writeString(assetKey);
+    }
+}
+
+bool CborPayload::contains(const char *assetName) {
+    CborInput input(buffer + HEADER_SIZE, output.getSize() - HEADER_SIZE);
+    CborParser parser(input);
+    for (unsigned int i = 0; i < assetCount; i++) {
+        if (!parser.next()) {
+            return false;
+        }
+        if (parser.type() == CBOR_TYPE_STRING && parser.asStringView().equals(assetName)) {
+            return true;
+        }
+        if (!parser.next() || !parser.skip()) {
+            return false;
+        }
+    }
+    return false;
 }
 
+// Like an asset, meta data is refused if getBytes() would have no room to add it
 bool CborPayload::setTimestamp(uint64_t timestamp) {
+    bool hadTimestamp = hasTimestamp;
+    uint64_t previous = this->timestamp;
     hasTimestamp = true;
     this->timestamp = timestamp;
+    if (!footerFits(output.getSize())) {
+        hasTimestamp = hadTimestamp;
+        this->timestamp = previous;
+        return false;
+    }
     return true;
 }
 
 bool CborPayload::setLocation(GeoLocation location) {
+    bool hadLocation = hasLocation;
+    GeoLocation previous = this->location;
     hasLocation = true;
     this->location = location;
+    if (!footerFits(output.getSize())) {
+        hasLocation = hadLocation;
+        this->location = previous;
+        return false;
+    }
     return true;
 }
 
-template<> void CborPayload::write(bool value) {
+// getBytes() writes the footer right after the assets
+bool CborPayload::footerFits(unsigned int end) {
+    if (!hasTimestamp && !hasLocation) {
+        return true;
+    }
+    CborCountingOutput counter;
+    CborWriter countingWriter(counter);
+    writeFooter(countingWriter);
+    return counter.getSize() <= capacity - end;
+}
+
+template<typename T> static void writeSigned(CborWriter *writer, T value) {
+    if (sizeof(T) > 4) {
+        writer->writeInt((int64_t)value);
+    } else {
+        writer->writeInt((int32_t)value);
+    }
+}
+
+template<typename T> static void writeUnsigned(CborWriter *writer, T value) {
+    if (sizeof(T) > 4) {
+        writer->writeInt((uint64_t)value);
+    } else {
+        writer->writeInt((uint32_t)value);
+    }
+}
+
+template<> void CborBuilder::write(CborWriter *writer, bool value) {
     writer->writeSpecial(20 + (value ? 1 : 0));
 }
 
-template<> void CborPayload::write(char *value) {
-    writer->writeString(value);
+template<> void CborBuilder::write(CborWriter *writer, char *value) {
+    writer->writeString(value, strlen(value));
 }
 
-template<> void CborPayload::write(const char *value) {
-    writer->writeString(value);
+template<> void CborBuilder::write(CborWriter *writer, const char *value) {
+    writer->writeString(value, strlen(value));
 }
 
-template<> void CborPayload::write(String value) {
-    char buffer[value.length() + 1];
-    value.toCharArray(buffer, value.length() + 1);
-    writer->writeString(buffer);
+template<> void CborBuilder::write(CborWriter *writer, String value) {
+    writer->writeString(value.c_str(), value.length());
 }
 
-template<> void CborPayload::write(int value) {
-    writer->writeInt(value);
+template<> void CborBuilder::write(CborWriter *writer, signed char value) {
+    writeSigned(writer, value);
 }
 
-template<> void CborPayload::write(float value) {
+template<> void CborBuilder::write(CborWriter *writer, unsigned char value) {
+    writeUnsigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, short value) {
+    writeSigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, unsigned short value) {
+    writeUnsigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, int value) {
+    writeSigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, unsigned int value) {
+    writeUnsigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, long value) {
+    writeSigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, unsigned long value) {
+    writeUnsigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, long long value) {
+    writeSigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, unsigned long long value) {
+    writeUnsigned(writer, value);
+}
+
+template<> void CborBuilder::write(CborWriter *writer, float value) {
     writer->writeFloat(value);
 }
 
-template<> void CborPayload::write(double value) {
+template<> void CborBuilder::write(CborWriter *writer, double value) {
     writer->writeDouble(value);
 }
 
-template<> void CborPayload::write(GeoLocation location) {
+template<> void CborBuilder::write(CborWriter *writer, GeoLocation location) {
     writer->writeTag(103);
     writer->writeArray(location.hasAltitude() ? 3 : 2);
     writer->writeFloat(location.latitude);
@@ -82,25 +224,130 @@ template<> void CborPayload::write(GeoLocation location) {
     }
 }
 
-unsigned char *CborPayload::getBytes() {
-    if (assetCount == 0) {
-        return 0;
+CborBuilder::CborBuilder(CborPayload *payload, unsigned int level, bool isObject) {
+    this->payload = payload;
+    this->asset = payload ? payload->assetId : 0;
+    this->id = payload ? payload->containerId : 0;
+    this->level = level;
+    this->isObject = isObject;
+}
+
+// False if the container couldn't be opened, or its asset has ended
+bool CborBuilder::isValid() {
+    return payload != NULL && payload->containerOpen && payload->assetId == asset;
+}
+
+bool CborBuilder::end() {
+    return isValid() && payload->endContainer();
+}
+
+// Only the innermost open container takes items, and only as many as it was opened with
+bool CborBuilder::take(bool member) {
+    if (!isValid() || isObject != member || level + 1 != payload->containerDepth
+        || payload->containerIds[level] != id) {
+        return false;
+    }
+    payload->containerItems[level]--;
+    while (payload->containerDepth > 0 && payload->containerItems[payload->containerDepth - 1] == 0) {
+        payload->containerDepth--;
+    }
+    return true;
+}
+
+bool CborBuilder::canOpen() {
+    return payload == NULL || payload->containerDepth < CBOR_BUILDER_DEPTH;
+}
+
+// The asset is only complete once the nested container is full as well.
+// Its parent may have been full already, and closed by take().
+CborBuilder CborBuilder::open(unsigned int count, bool isObject) {
+    unsigned int childLevel = payload->containerDepth;
+    payload->pushContainer(count);
+    return CborBuilder(payload, childLevel, isObject);
+}
+
+template<typename T> bool CborBuilder::set(char *name, T value) {
+    if (!take(true)) {
+        return false;
+    }
+    payload->writer.writeString(name, strlen(name));
+    write(&payload->writer, value);
+    return true;
+}
+
+template<typename T> bool CborBuilder::add(T value) {
+    if (!take(false)) {
+        return false;
+    }
+    write(&payload->writer, value);
+    return true;
+}
+
+bool CborBuilder::setBytes(char *name, const unsigned char *data, unsigned int size) {
+    if (!take(true)) {
+        return false;
+    }
+    payload->writer.writeString(name, strlen(name));
+    payload->writer.writeBytes(data, size);
+    return true;
+}
+
+bool CborBuilder::addBytes(const unsigned char *data, unsigned int size) {
+    if (!take(false)) {
+        return false;
+    }
+    payload->writer.writeBytes(data, size);
+    return true;
+}
+
+CborBuilder CborBuilder::setArray(char *name, unsigned int count) {
+    if (!canOpen() || !take(true)) {
+        return CborBuilder(NULL, 0, false);
+    }
+    payload->writer.writeString(name, strlen(name));
+    payload->writer.writeArray(count);
+    return open(count, false);
+}
+
+CborBuilder CborBuilder::setObject(char *name, unsigned int count) {
+    if (!canOpen() || !take(true)) {
+        return CborBuilder(NULL, 0, true);
+    }
+    payload->writer.writeString(name, strlen(name));
+    payload->writer.writeMap(count);
+    return open(count, true);
+}
+
+CborBuilder CborBuilder::addArray(unsigned int count) {
+    if (!canOpen() || !take(false)) {
+        return CborBuilder(NULL, 0, false);
+    }
+    payload->writer.writeArray(count);
+    return open(count, false);
+}
+
+CborBuilder CborBuilder::addObject(unsigned int count) {
+    if (!canOpen() || !take(false)) {
+        return CborBuilder(NULL, 0, true);
     }
+    payload->writer.writeMap(count);
+    return open(count, true);
+}
 
+// Tag 120 and the array around the assets are left out when there's no meta data
+void CborPayload::writeHeader(CborWriter &headerWriter) {
     unsigned char meta = 1;
     if (hasTimestamp) meta = 2;
     if (hasLocation) meta = 3;
 
-    auto headerOutput = CborStaticOutput(buffer, capacity);
-    auto headerWriter = CborWriter(headerOutput);
-    headerWriter.writeTag(120);
-    headerWriter.writeArray(meta);
+    if (meta > 1) {
+        headerWriter.writeTag(120);
+        headerWriter.writeArray(meta);
+    }
     headerWriter.writeMap(assetCount);
+}
 
-    auto footerOutput = CborStaticOutput(
-        buffer + output->getSize(), capacity - output->getSize());
-    auto footerWriter = CborWriter(footerOutput);
-
+void CborPayload::writeFooter(CborWriter &footerWriter) {
     if (hasTimestamp) {
         footerWriter.writeTag(1); // unix timestamp
         footerWriter.writeInt(timestamp);
@@ -116,42 +363,185 @@ unsigned char *CborPayload::getBytes() {
             footerWriter.writeFloat(location.altitude);
         }
     }
+}
 
-    if (meta > 1) {
-        return buffer;
-    } else {
-        return buffer + 3;
+unsigned char *CborPayload::getBytes() {
+    endContainer();
+    if (assetCount == 0) {
+        return 0;
     }
+
+    unsigned char header[HEADER_SIZE];
+    CborStaticOutput headerOutput(header, sizeof header);
+    CborWriter headerWriter(headerOutput);
+    writeHeader(headerWriter);
+    unsigned char *start = buffer + HEADER_SIZE - headerOutput.getSize();
+    memcpy(start, header, headerOutput.getSize());
+
+    auto footerOutput = CborStaticOutput(
+        buffer + output.getSize(), capacity - output.getSize());
+    auto footerWriter = CborWriter(footerOutput);
+    writeFooter(footerWriter);
+
+    return start;
 }
 
 unsigned int CborPayload::getSize() {
+    return encodedSize();
+}
+
+unsigned int CborPayload::encodedSize() {
+    endContainer();
     if (assetCount == 0) {
         return 0;
     }
-    auto size = output->getSize();
-    if (hasLocation) {
-        size += 3 + 5 + 5; // geotag, latitude, longitude
-        if (location.hasAltitude()) size += 5; // altitude
-        if (!hasTimestamp) size += 1; // null for location
+    CborCountingOutput counter;
+    CborWriter countingWriter(counter);
+    writeHeader(countingWriter);
+    writeFooter(countingWriter);
+    return counter.getSize() + output.getSize() - HEADER_SIZE;
+}
+
+// Writes the header, the assets straight from the buffer and then the footer,
+// so the buffer doesn't need room for the meta data. Header and footer are
+// put together first, so that's three writes to out.
+size_t CborPayload::writeTo(Print &out) {
+    endContainer();
+    if (assetCount == 0) {
+        return 0;
+    }
+    unsigned char header[HEADER_SIZE];
+    CborStaticOutput headerOutput(header, sizeof header);
+    CborWriter headerWriter(headerOutput);
+    writeHeader(headerWriter);
+
+    unsigned char footer[MAX_FOOTER_SIZE];
+    CborStaticOutput footerOutput(footer, sizeof footer);
+    CborWriter footerWriter(footerOutput);
+    writeFooter(footerWriter);
+
+    size_t written = out.write(header, headerOutput.getSize());
+    written += out.write(buffer + HEADER_SIZE, output.getSize() - HEADER_SIZE);
+    if (footerOutput.getSize() > 0) {
+        written += out.write(footer, footerOutput.getSize());
     }
-    if (hasTimestamp) size += 6; // time tag, int
-    if (!hasTimestamp && !hasLocation) size -= 3;
+    return written;
+}
 
-    return size;
+// An asset that didn't fit completely, meta data included, is taken out again
+bool CborPayload::commitAsset(unsigned int start) {
+    if (output.hasOverflowed() || assetCount == MAX_ASSETS || !footerFits(output.getSize())) {
+        output.rewind(start);
+        return false;
+    }
+    assetCount++;
+    return true;
 }
 
 template<typename T> bool CborPayload::set(char *assetName, T value) {
-    writer->writeString(assetName);
-    write(value);
+    endContainer();
+    unsigned int start = output.getSize();
+    writeAssetName(assetName);
+    CborBuilder::write(&writer, value);
+    return commitAsset(start);
+}
+
+template<typename T> bool CborPayload::set(const CborKey &assetKey, T value) {
+    endContainer();
+    unsigned int start = output.getSize();
+    writeAssetName(assetKey);
+    CborBuilder::write(&writer, value);
+    return commitAsset(start);
+}
+
+bool CborPayload::set(char *assetName, float value, const Quantization &quantization) {
+    if (!quantization.isValid())
+        return false;
+    endContainer();
+    unsigned int start = output.getSize();
+    writeAssetName(assetName);
+    writer.writeQuantized(value, quantization);
+    return commitAsset(start);
+}
+
+bool CborPayload::set(const CborKey &assetKey, float value, const Quantization &quantization) {
+    if (!quantization.isValid())
+        return false;
+    endContainer();
+    unsigned int start = output.getSize();
+    writeAssetName(assetKey);
+    writer.writeQuantized(value, quantization);
+    return commitAsset(start);
+}
+
+bool CborPayload::setBytes(char *assetName, const unsigned char *data, unsigned int size) {
+    endContainer();
+    unsigned int start = output.getSize();
+    writeAssetName(assetName);
+    writer.writeBytes(data, size);
+    return commitAsset(start);
+}
+
+CborBuilder CborPayload::setArray(char *assetName, unsigned int count) {
+    return openContainer(assetName, count, false);
+}
+
+CborBuilder CborPayload::setObject(char *assetName, unsigned int count) {
+    return openContainer(assetName, count, true);
+}
+
+CborBuilder CborPayload::openContainer(char *assetName, unsigned int count, bool isObject) {
+    endContainer();
+    containerStart = output.getSize();
+    writeAssetName(assetName);
+    if (isObject) {
+        writer.writeMap(count);
+    } else {
+        writer.writeArray(count);
+    }
+    containerOpen = true;
+    containerDepth = 0;
+    pushContainer(count);
+    assetId = containerId;
+    return CborBuilder(this, 0, isObject);
+}
+
+// An empty container is full straight away
+void CborPayload::pushContainer(unsigned int count) {
+    containerId++;
+    if (count > 0) {
+        containerItems[containerDepth] = count;
+        containerIds[containerDepth++] = containerId;
+    }
+}
+
+// The asset is only counted once all of its items are there, and taken
+// out again if they aren't or didn't fit
+bool CborPayload::endContainer() {
+    if (!containerOpen) {
+        return false;
+    }
+    containerOpen = false;
+    if (containerDepth > 0 || output.hasOverflowed() || assetCount == MAX_ASSETS
+        || !footerFits(output.getSize())) {
+        output.rewind(containerStart);
+        return false;
+    }
     assetCount++;
     return true;
 }
 
-template bool CborPayload::set(char *assetName, bool value);
-template bool CborPayload::set(char *assetName, char *value);
-template bool CborPayload::set(char *assetName, const char *value);
-template bool CborPayload::set(char *assetName, String value);
-template bool CborPayload::set(char *assetName, int value);
-template bool CborPayload::set(char *assetName, float value);
-template bool CborPayload::set(char *assetName, double value);
-template bool CborPayload::set(char *assetName, GeoLocation value);
+#define CBOR_VALUE_TYPES(X) \
+    X(bool) X(char *) X(const char *) X(String) \
+    X(signed char) X(unsigned char) X(short) X(unsigned short) \
+    X(int) X(unsigned int) X(long) X(unsigned long) \
+    X(long long) X(unsigned long long) \
+    X(float) X(double) X(GeoLocation)
+
+#define CBOR_INSTANTIATE_SET(T) \
+    template bool CborPayload::set(char *assetName, T value); \
+    template bool CborPayload::set(const CborKey &assetKey, T value); \
+    template bool CborBuilder::set(char *name, T value); \
+    template bool CborBuilder::add(T value);
+
+CBOR_VALUE_TYPES(CBOR_INSTANTIATE_SET)
@@ -2,30 +2,99 @@
 #define CBOR_PAYLOAD_H_
 
 #include "CborEncoder.h"
+#include "CborAssetDictionary.h"
 #include "Payload.h"
 #include "GeoLocation.h"
 
 #include <string.h>
 #include <stdint.h>
 
+class CborPayload;
+
+// How deep containers can be nested within one asset
+#define CBOR_BUILDER_DEPTH 8
+
+// Writes the items of a nested array or object straight into its payload.
+// The item count is fixed when the container is opened, and exactly that
+// many items have to follow. While a nested container is open, only it can
+// be written to; its parent takes items again once it's full. end() then
+// adds the asset to the payload; an asset that isn't complete or didn't fit
+// is taken out again. Setting another asset or getting the bytes ends it as
+// well.
+class CborBuilder {
+public:
+    template<typename T> bool set(char *name, T value);
+    template<typename T> bool add(T value);
+
+    bool setBytes(char *name, const unsigned char *data, unsigned int size);
+    bool addBytes(const unsigned char *data, unsigned int size);
+
+    CborBuilder setArray(char *name, unsigned int count);
+    CborBuilder setObject(char *name, unsigned int count);
+    CborBuilder addArray(unsigned int count);
+    CborBuilder addObject(unsigned int count);
+
+    // False, and the asset is taken out, if it's incomplete or didn't fit
+    bool end();
+    bool isValid();
+
+private:
+    friend class CborPayload;
+    CborBuilder(CborPayload *payload, unsigned int level, bool isObject);
+
+    CborPayload *payload;
+    unsigned int asset;
+    // Which container this is, as an earlier sibling may have had the same level
+    unsigned int id;
+    unsigned int level;
+    bool isObject;
+
+    bool take(bool member);
+    bool canOpen();
+    CborBuilder open(unsigned int count, bool isObject);
+    template<typename T> static void write(CborWriter *writer, T value);
+};
+
 class CborPayload : public Payload {
 public:
     CborPayload(unsigned int capacity = 256);
+    // Writes into buffer, which isn't copied or released
+    CborPayload(unsigned char *buffer, unsigned int capacity);
     ~CborPayload();
 
+    // These return false, leaving the payload as it was, if the asset doesn't fit
     template<typename T> bool set(char *assetName, T value);
+    template<typename T> bool set(const CborKey &assetKey, T value);
+    bool set(char *assetName, float value, const Quantization &quantization);
+    bool set(const CborKey &assetKey, float value, const Quantization &quantization);
+    bool setBytes(char *assetName, const unsigned char *data, unsigned int size);
+    CborBuilder setArray(char *assetName, unsigned int count);
+    CborBuilder setObject(char *assetName, unsigned int count);
 
+    // True if an asset with this name has been set. Assets keyed by the
+    // dictionary and a container that's still being built aren't looked at.
+    bool contains(const char *assetName);
+
+    void setDictionary(CborAssetDictionary *dictionary);
+    CborAssetDictionary *getDictionary();
+    // True if an asset was written with its dictionary key instead of its name
+    bool usesDictionaryKeys();
+
+    // False, leaving the payload as it was, if there's no room for them after the assets
     bool setTimestamp(uint64_t timestamp);
     bool setLocation(GeoLocation location);
 
     virtual unsigned char* getBytes();
     virtual unsigned int getSize();
     virtual void reset();
+    virtual unsigned int encodedSize();
+    virtual size_t writeTo(Print &out);
 
 private:
     unsigned char *buffer;
-    CborStaticOutput *output;
-    CborWriter *writer;
+    CborStaticOutput output;
+    CborWriter writer;
+    bool releaseBuffer = true;
 
     bool hasTimestamp = false;
     bool hasLocation = false;
@@ -33,8 +102,29 @@ private:
     unsigned int assetCount = 0;
     uint64_t timestamp;
     GeoLocation location;
+    CborAssetDictionary *dictionary = NULL;
+    bool hasDictionaryKeys = false;
+
+    // The asset a CborBuilder is writing, if any
+    friend class CborBuilder;
+    bool containerOpen = false;
+    unsigned int containerStart;
+    unsigned int containerId = 0;
+    unsigned int assetId = 0;
+    // Items still missing from each open level, the innermost one last
+    unsigned int containerItems[CBOR_BUILDER_DEPTH];
+    unsigned int containerIds[CBOR_BUILDER_DEPTH];
+    unsigned int containerDepth = 0;
 
-    template<typename T> void write(T value);
+    void writeAssetName(char *assetName);
+    void writeAssetName(const CborKey &assetKey);
+    bool commitAsset(unsigned int start);
+    CborBuilder openContainer(char *assetName, unsigned int count, bool isObject);
+    bool endContainer();
+    void pushContainer(unsigned int count);
+    void writeHeader(CborWriter &headerWriter);
+    void writeFooter(CborWriter &footerWriter);
+    bool footerFits(unsigned int end);
 };
 
 #endif
@@ -0,0 +1,248 @@
+#ifndef CBOR_SCHEMA_H_
+#define CBOR_SCHEMA_H_
+
+#include "CborParser.h"
+
+#include <string.h>
+#include <stdint.h>
+
+// Decodes a CBOR map straight into a struct, in one pass and without
+// allocating. Describe the struct once:
+//
+//   struct Command { int speed; float angle; bool enabled; char mode[16]; };
+//
+//   const CborField<Command> commandFields[] = {
+//       CborField<Command>("speed", &Command::speed),
+//       CborField<Command>("angle", &Command::angle),
+//       CborField<Command>("enabled", &Command::enabled),
+//       CborField<Command>("mode", &Command::mode),
+//   };
+//   const CborSchema<Command> commandSchema(commandFields);
+//
+// and decode with commandSchema.decode(input, command). Keys are matched by
+// their FNV-1a hash first and unknown keys are skipped. Supported members
+// are bool, all integer types (range checked), float, double, char arrays
+// (copied and terminated) and CborStringView (pointing into the input).
+// Fields of all but char arrays can be constexpr.
+
+constexpr uint32_t cborFieldHash(const char *name, uint32_t hash = 2166136261u) {
+    return *name ? cborFieldHash(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+}
+
+inline uint32_t cborFieldHash(CborStringView name) {
+    uint32_t hash = 2166136261u;
+    for (unsigned int i = 0; i < name.length; i++) {
+        hash = (hash ^ (unsigned char)name.data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+inline bool cborReadValue(CborParser &parser, bool &value) {
+    if (parser.type() != CBOR_TYPE_SPECIAL || (parser.asSpecial() != 20 && parser.asSpecial() != 21)) {
+        return false;
+    }
+    value = parser.asBool();
+    return true;
+}
+
+template<typename I> bool cborReadInteger(CborParser &parser, I &value) {
+    if (parser.type() != CBOR_TYPE_INTEGER) {
+        return false;
+    }
+    bool isSigned = (I)-1 < 0;
+    if (parser.isNegative()) {
+        int64_t wide = parser.asInt();
+        if (!isSigned || !parser.fitsInt() || (int64_t)(I)wide != wide) {
+            return false;
+        }
+        value = (I)wide;
+    } else {
+        uint64_t wide = parser.asUnsigned();
+        if ((uint64_t)(I)wide != wide || (isSigned && (I)wide < 0)) {
+            return false;
+        }
+        value = (I)wide;
+    }
+    return true;
+}
+
+inline bool cborReadValue(CborParser &parser, signed char &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, unsigned char &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, short &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, unsigned short &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, int &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, unsigned int &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, long &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, unsigned long &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, long long &value) { return cborReadInteger(parser, value); }
+inline bool cborReadValue(CborParser &parser, unsigned long long &value) { return cborReadInteger(parser, value); }
+
+inline bool cborReadValue(CborParser &parser, double &value) {
+    if (parser.type() != CBOR_TYPE_FLOAT && parser.type() != CBOR_TYPE_INTEGER) {
+        return false;
+    }
+    value = parser.asFloat();
+    return true;
+}
+
+inline bool cborReadValue(CborParser &parser, float &value) {
+    double wide;
+    if (!cborReadValue(parser, wide)) {
+        return false;
+    }
+    value = wide;
+    return true;
+}
+
+inline bool cborReadValue(CborParser &parser, CborStringView &value) {
+    if (parser.type() != CBOR_TYPE_STRING && parser.type() != CBOR_TYPE_BYTES) {
+        return false;
+    }
+    value = parser.asStringView();
+    return true;
+}
+
+template<unsigned int N> bool cborReadValue(CborParser &parser, char (&value)[N]) {
+    if (parser.type() != CBOR_TYPE_STRING || parser.asStringView().length >= N) {
+        return false;
+    }
+    CborStringView str = parser.asStringView();
+    memcpy(value, str.data, str.length);
+    value[str.length] = 0;
+    return true;
+}
+
+#define CBOR_FIELD_TYPES(X) \
+    X(bool, Bool) X(signed char, SignedChar) X(unsigned char, UnsignedChar) \
+    X(short, Short) X(unsigned short, UnsignedShort) X(int, Int) X(unsigned int, UnsignedInt) \
+    X(long, Long) X(unsigned long, UnsignedLong) \
+    X(long long, LongLong) X(unsigned long long, UnsignedLongLong) \
+    X(float, Float) X(double, Double) X(CborStringView, View)
+
+// Holds the member pointer of any supported type, so a field can be
+// constexpr; read is the reader for the one that's set. Char arrays have a
+// type per size, so those are stored as char T::* instead, and a field for
+// one can't be constexpr.
+template<typename T> union CborMember {
+#define CBOR_FIELD_MEMBER(type, suffix) \
+    type T::*as##suffix; \
+    constexpr CborMember(type T::*member) : as##suffix(member) {}
+    CBOR_FIELD_TYPES(CBOR_FIELD_MEMBER)
+#undef CBOR_FIELD_MEMBER
+    char T::*asText;
+    CborMember(char T::*member) : asText(member) {}
+};
+
+template<typename T> class CborField {
+public:
+#define CBOR_FIELD_CONSTRUCTOR(type, suffix) \
+    constexpr CborField(const char *name, type T::*member) \
+        : name(name), hash(cborFieldHash(name)), member(member), read(&CborField::read##suffix) {}
+    CBOR_FIELD_TYPES(CBOR_FIELD_CONSTRUCTOR)
+#undef CBOR_FIELD_CONSTRUCTOR
+
+    template<unsigned int N> CborField(const char *name, char (T::*member)[N])
+        : name(name), hash(cborFieldHash(name)),
+          member(reinterpret_cast<char T::*>(member)), read(&CborField::readText<N>) {}
+
+    const char *name;
+    uint32_t hash;
+    CborMember<T> member;
+    bool (*read)(T &target, const CborMember<T> &member, CborParser &parser);
+
+private:
+#define CBOR_FIELD_READER(type, suffix) \
+    static bool read##suffix(T &target, const CborMember<T> &member, CborParser &parser) { \
+        return cborReadValue(parser, target.*member.as##suffix); \
+    }
+    CBOR_FIELD_TYPES(CBOR_FIELD_READER)
+#undef CBOR_FIELD_READER
+
+    template<unsigned int N> static bool readText(T &target, const CborMember<T> &member, CborParser &parser) {
+        return cborReadValue(parser, target.*reinterpret_cast<char (T::*)[N]>(member.asText));
+    }
+};
+
+// Bit i of found and mistyped refers to the i-th field of the schema
+class CborSchemaResult {
+public:
+    uint32_t found = 0;
+    uint32_t mistyped = 0;
+    uint32_t expected = 0;
+    const char *error = NULL;
+
+    bool isValid() { return error == NULL && mistyped == 0 && found == expected; }
+    bool isMissing(unsigned int field) { return !(found & (1UL << field)); }
+    bool isMistyped(unsigned int field) { return mistyped & (1UL << field); }
+};
+
+template<typename T> class CborSchema {
+public:
+    template<unsigned int N> CborSchema(const CborField<T> (&fields)[N]) : fields(fields), count(N) {
+        static_assert(N <= 32, "CborSchema supports up to 32 fields");
+    }
+
+    CborSchemaResult decode(CborInput &input, T &target) const {
+        CborParser parser(input);
+        return decode(parser, target);
+    }
+
+    // Decodes the next item of parser, which has to be a map
+    CborSchemaResult decode(CborParser &parser, T &target) const {
+        CborSchemaResult result;
+        result.expected = count == 32 ? 0xFFFFFFFFUL : (1UL << count) - 1;
+
+        if (!parser.next() || parser.type() != CBOR_TYPE_MAP) {
+            result.error = parser.type() == CBOR_TYPE_ERROR ? parser.getError() : "expected a map";
+            return result;
+        }
+
+        unsigned int entries = parser.asCount();
+        for (unsigned int entry = 0; entry < entries; entry++) {
+            if (!parser.next()) {
+                result.error = parser.type() == CBOR_TYPE_ERROR ? parser.getError() : "truncated map";
+                return result;
+            }
+
+            int field = -1;
+            if (parser.type() == CBOR_TYPE_STRING) {
+                CborStringView key = parser.asStringView();
+                uint32_t hash = cborFieldHash(key);
+                for (unsigned int i = 0; i < count; i++) {
+                    if (fields[i].hash == hash && key.equals(fields[i].name)) {
+                        field = i;
+                        break;
+                    }
+                }
+            } else if (!parser.skip()) {
+                result.error = "invalid map key";
+                return result;
+            }
+
+            if (!parser.next()) {
+                result.error = parser.type() == CBOR_TYPE_ERROR ? parser.getError() : "truncated map";
+                return result;
+            }
+
+            if (field >= 0 && fields[field].read(target, fields[field].member, parser)) {
+                result.found |= 1UL << field;
+                result.mistyped &= ~(1UL << field);
+            } else {
+                if (field >= 0) {
+                    result.mistyped |= 1UL << field;
+                }
+                if (!parser.skip()) {
+                    result.error = parser.getError();
+                    return result;
+                }
+            }
+        }
+        return result;
+    }
+
+private:
+    const CborField<T> *fields;
+    unsigned int count;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include <stdint.h>
+
+#include "CborSeriesPayload.h"
+
+// RFC 8746 float32 typed array in this CPU's byte order, so values are copied as they are
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static const unsigned char floatArrayTag = 85;
+#else
+static const unsigned char floatArrayTag = 81;
+#endif
+
+// Number of bytes CBOR needs for a major type header carrying this value
+static unsigned int headerSize(uint64_t value) {
+    if (value < 24ULL) return 1;
+    if (value < 256ULL) return 2;
+    if (value < 65536ULL) return 3;
+    if (value < 4294967296ULL) return 5;
+    return 9;
+}
+
+// name, [ [deltas], 85(h'values') ]
+unsigned int CborSeriesPayload::Asset::getSize() {
+    return headerSize(nameLength) + nameLength + 1
+        + headerSize(count) + deltaBytes
+        + 2 + headerSize(count * 4) + count * 4;
+}
+
+CborSeriesPayload::CborSeriesPayload(unsigned int capacity, unsigned int maxSamples, unsigned int maxAssets) {
+    this->capacity = capacity;
+    this->maxSamples = maxSamples;
+    this->maxAssets = maxAssets;
+    buffer = new unsigned char[capacity];
+    assets = new Asset[maxAssets];
+    reset();
+}
+
+CborSeriesPayload::~CborSeriesPayload() {
+    delete[] buffer;
+    delete[] assets;
+}
+
+void CborSeriesPayload::reset() {
+    sampleCount = 0;
+    assetCount = 0;
+    baseTimestamp = 0;
+    size = 0;
+}
+
+int CborSeriesPayload::findAsset(const char *assetName) {
+    for (unsigned int i = 0; i < assetCount; i++) {
+        if (assets[i].name == assetName || strcmp(assets[i].name, assetName) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The outer array, the base timestamp and the map header come first
+unsigned int CborSeriesPayload::getAssetsOffset() {
+    return 1 + headerSize(baseTimestamp) + headerSize(assetCount);
+}
+
+void CborSeriesPayload::writeHeader(unsigned char *at, uint8_t majorType, uint64_t value) {
+    majorType <<= 5;
+    unsigned int length = headerSize(value);
+    if (length == 1) {
+        at[0] = majorType | (uint8_t)value;
+        return;
+    }
+    at[0] = majorType | (length == 2 ? 24 : length == 3 ? 25 : length == 5 ? 26 : 27);
+    for (unsigned int i = length - 1; i > 0; i--) {
+        at[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+bool CborSeriesPayload::add(const char *assetName, uint64_t timestamp, float value) {
+    if (sampleCount >= maxSamples) {
+        return false;
+    }
+
+    uint64_t base = sampleCount == 0 ? timestamp : baseTimestamp;
+    int index = findAsset(assetName);
+    Asset added;
+    if (index < 0) {
+        if (assetCount >= maxAssets) {
+            return false;
+        }
+        added.name = assetName;
+        added.nameLength = strlen(assetName);
+        added.lastTimestamp = base;
+        added.count = 0;
+        added.deltaBytes = 0;
+    }
+    Asset &asset = index < 0 ? added : assets[index];
+
+    if (timestamp < asset.lastTimestamp || timestamp - asset.lastTimestamp > 0xFFFFFFFFULL) {
+        return false;
+    }
+    uint32_t delta = timestamp - asset.lastTimestamp;
+
+    // Work out where everything goes before moving anything
+    unsigned int headerBefore = sampleCount == 0 ? 0 : getAssetsOffset();
+    unsigned int headerAfter = 1 + headerSize(base) + headerSize(assetCount + (index < 0 ? 1 : 0));
+    unsigned int oldAssetSize = index < 0 ? 0 : asset.getSize();
+    Asset grown = asset;
+    grown.count++;
+    grown.deltaBytes += headerSize(delta);
+    unsigned int newSize = size - headerBefore + headerAfter - oldAssetSize + grown.getSize();
+    if (newSize > capacity) {
+        return false;
+    }
+
+    // Start of this asset's part, before and after the header changes
+    unsigned int assetStart = headerBefore;
+    for (int i = 0; i < index; i++) {
+        assetStart += assets[i].getSize();
+    }
+    if (index < 0) {
+        assetStart = size;
+    }
+    unsigned int newAssetStart = assetStart - headerBefore + headerAfter;
+
+    // Assets after this one move to the end
+    unsigned int assetEnd = assetStart + oldAssetSize;
+    unsigned int newAssetEnd = newAssetStart + grown.getSize();
+    memmove(buffer + newAssetEnd, buffer + assetEnd, size - assetEnd);
+
+    // Values first, as they move furthest, then the deltas
+    unsigned int nameSize = headerSize(asset.nameLength) + asset.nameLength;
+    unsigned int oldDeltas = assetStart + nameSize + 1 + headerSize(asset.count);
+    unsigned int oldValues = oldDeltas + asset.deltaBytes + 2 + headerSize(asset.count * 4);
+    unsigned int newDeltas = newAssetStart + nameSize + 1 + headerSize(grown.count);
+    unsigned int newValues = newDeltas + grown.deltaBytes + 2 + headerSize(grown.count * 4);
+    memmove(buffer + newValues, buffer + oldValues, asset.count * 4);
+    memmove(buffer + newDeltas, buffer + oldDeltas, asset.deltaBytes);
+    if (headerAfter != headerBefore) {
+        memmove(buffer + headerAfter, buffer + headerBefore, assetStart - headerBefore);
+    }
+
+    // Then write what's new, back to front
+    memcpy(buffer + newValues + asset.count * 4, &value, 4);
+    writeHeader(buffer + newValues - headerSize(grown.count * 4), 2, grown.count * 4);
+    buffer[newValues - headerSize(grown.count * 4) - 2] = 0xD8;
+    buffer[newValues - headerSize(grown.count * 4) - 1] = floatArrayTag;
+    writeHeader(buffer + newDeltas + asset.deltaBytes, 0, delta);
+    writeHeader(buffer + newDeltas - headerSize(grown.count), 4, grown.count);
+    // The name is written again, as it moves when the header grows
+    buffer[newAssetStart + nameSize] = 0x82;
+    writeHeader(buffer + newAssetStart, 3, asset.nameLength);
+    memcpy(buffer + newAssetStart + headerSize(asset.nameLength), asset.name, asset.nameLength);
+
+    if (index < 0) {
+        index = assetCount++;
+    }
+    assets[index] = grown;
+    assets[index].lastTimestamp = timestamp;
+
+    baseTimestamp = base;
+    buffer[0] = 0x82;
+    writeHeader(buffer + 1, 0, baseTimestamp);
+    writeHeader(buffer + 1 + headerSize(baseTimestamp), 5, assetCount);
+
+    sampleCount++;
+    size = newSize;
+    return true;
+}
+
+// True once a sample for an already known asset might no longer fit
+bool CborSeriesPayload::isFull() {
+    if (sampleCount >= maxSamples) {
+        return true;
+    }
+    // Largest delta and a float, plus the headers of both arrays growing by 2 bytes
+    return size + 5 + 4 + 2 + 2 > capacity;
+}
+
+unsigned int CborSeriesPayload::getSampleCount() {
+    return sampleCount;
+}
+
+unsigned char *CborSeriesPayload::getBytes() {
+    if (sampleCount == 0) {
+        return 0;
+    }
+    return buffer;
+}
+
+unsigned int CborSeriesPayload::getSize() {
+    return size;
+}
@@ -0,0 +1,70 @@
+#ifndef CBOR_SERIES_PAYLOAD_H_
+#define CBOR_SERIES_PAYLOAD_H_
+
+#include "CborEncoder.h"
+#include "Payload.h"
+
+#include <string.h>
+#include <stdint.h>
+
+// Published below device/<id>/state instead of to it, as the platform only
+// decodes tag 120 data points there
+#define SERIES_TOPIC_SUFFIX "/series"
+
+// Collects many (timestamp, value) samples per asset and encodes them as
+//
+//   [base, { "asset": [[delta, delta, ...], 85(h'values')], ... }]
+//
+// where base is the timestamp of the first sample, every delta is the
+// distance to the previous sample of the same asset (the first one to base)
+// and the values are an RFC 8746 float32 typed array (tag 85 little endian,
+// 81 big endian). This isn't a tag 120 data point, so the receiving side has
+// to decode it itself.
+//
+// The buffer always holds the finished message: a sample is moved into its
+// asset's part right away, so samples aren't stored anywhere else. Asset
+// names are not copied, so they have to outlive the payload.
+class CborSeriesPayload : public Payload {
+public:
+    CborSeriesPayload(unsigned int capacity = 512, unsigned int maxSamples = 64, unsigned int maxAssets = 4);
+    ~CborSeriesPayload();
+
+    bool add(const char *assetName, uint64_t timestamp, float value);
+    bool isFull();
+    unsigned int getSampleCount();
+
+    virtual unsigned char* getBytes();
+    virtual unsigned int getSize();
+    virtual void reset();
+
+private:
+    class Asset {
+    public:
+        const char *name;
+        unsigned int nameLength;
+        uint64_t lastTimestamp;
+        unsigned int count;
+        unsigned int deltaBytes;    // Encoded size of all deltas, without the array header
+
+        unsigned int getSize();
+    };
+
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int size;
+
+    unsigned int maxSamples;
+    unsigned int sampleCount;
+
+    Asset *assets;
+    unsigned int maxAssets;
+    unsigned int assetCount;
+
+    uint64_t baseTimestamp;
+
+    int findAsset(const char *assetName);
+    unsigned int getAssetsOffset();
+    void writeHeader(unsigned char *at, uint8_t majorType, uint64_t value);
+};
+
+#endif
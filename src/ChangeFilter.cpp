@@ -0,0 +1,191 @@
+#include <string.h>
+#include <math.h>
+
+#include "ChangeFilter.h"
+
+ChangeFilter::ChangeFilter() {
+    memset(slots, EMPTY, sizeof slots);
+    for (unsigned int i = 0; i < CHANGE_FILTER_MAX_ASSETS; i++) {
+        entries[i].used = false;
+    }
+}
+
+// FNV-1a
+uint32_t ChangeFilter::hashName(const char *name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+int ChangeFilter::findSlot(const char *asset, uint32_t hash) {
+    for (unsigned int probe = 0; probe < slotCount; probe++) {
+        unsigned int slot = (hash + probe) % slotCount;
+        if (slots[slot] == EMPTY) {
+            return -1;
+        }
+        if (slots[slot] != REMOVED) {
+            Entry &entry = entries[slots[slot] - 1];
+            if (entry.hash == hash && strcmp(entry.name, asset) == 0) {
+                return slot;
+            }
+        }
+    }
+    return -1;
+}
+
+ChangeFilter::Entry *ChangeFilter::find(const char *asset) {
+    int slot = findSlot(asset, hashName(asset));
+    return slot < 0 ? NULL : &entries[slots[slot] - 1];
+}
+
+bool ChangeFilter::add(const char *asset, float deadband, float relativeDeadband,
+                       unsigned long minInterval, unsigned long heartbeat) {
+    if (strlen(asset) >= CHANGE_FILTER_NAME_LENGTH) {
+        return false;
+    }
+    uint32_t hash = hashName(asset);
+    Entry *entry = find(asset);
+
+    if (entry == NULL) {
+        unsigned int index = 0;
+        while (index < CHANGE_FILTER_MAX_ASSETS && entries[index].used) {
+            index++;
+        }
+        if (index == CHANGE_FILTER_MAX_ASSETS) {
+            return false;
+        }
+        // There's always a free slot, as there are more slots than entries
+        unsigned int slot = hash % slotCount;
+        while (slots[slot] != EMPTY && slots[slot] != REMOVED) {
+            slot = (slot + 1) % slotCount;
+        }
+        slots[slot] = index + 1;
+
+        entry = &entries[index];
+        strcpy(entry->name, asset);
+        entry->hash = hash;
+        entry->used = true;
+        entry->stats = ChangeFilterStats();
+    }
+
+    entry->deadband = fabsf(deadband);
+    entry->relativeDeadband = fabsf(relativeDeadband);
+    entry->minInterval = minInterval;
+    entry->heartbeat = heartbeat;
+    entry->hasLast = false;
+    entry->last = 0;
+    entry->lastText[0] = '\0';
+    entry->lastTextLength = 0;
+    entry->lastTextHash = 0;
+    return true;
+}
+
+bool ChangeFilter::remove(const char *asset) {
+    int slot = findSlot(asset, hashName(asset));
+    if (slot < 0) {
+        return false;
+    }
+    entries[slots[slot] - 1].used = false;
+    slots[slot] = REMOVED;
+    return true;
+}
+
+bool ChangeFilter::contains(const char *asset) {
+    return find(asset) != NULL;
+}
+
+// First values and heartbeats are always sent, anything else only if it
+// changed and minInterval has passed
+bool ChangeFilter::decide(Entry *entry, bool changed, unsigned long now) {
+    unsigned long elapsed = now - entry->lastSent;
+
+    if (!entry->hasLast) {
+        return true;
+    } else if (entry->heartbeat > 0 && elapsed >= entry->heartbeat) {
+        return true;
+    } else if (entry->minInterval > 0 && elapsed < entry->minInterval) {
+        return false;
+    }
+    return changed;
+}
+
+bool ChangeFilter::check(const char *asset, double value, unsigned long now) {
+    Entry *entry = find(asset);
+    if (entry == NULL) {
+        return true;
+    }
+
+    bool changed;
+    if (isnan(value) || isnan(entry->last)) {
+        changed = isnan(value) != isnan(entry->last);
+    } else {
+        double threshold = entry->relativeDeadband * fabs(entry->last);
+        if (threshold < entry->deadband) {
+            threshold = entry->deadband;
+        }
+        changed = fabs(value - entry->last) > threshold;
+    }
+    return decide(entry, changed, now);
+}
+
+bool ChangeFilter::check(const char *asset, const char *value, unsigned long now) {
+    Entry *entry = find(asset);
+    if (entry == NULL) {
+        return true;
+    }
+
+    unsigned int length = strlen(value);
+    uint32_t hash = length < CHANGE_FILTER_TEXT_LENGTH ? 0 : hashName(value);
+    bool changed = length != entry->lastTextLength || hash != entry->lastTextHash
+        || strncmp(value, entry->lastText, CHANGE_FILTER_TEXT_LENGTH - 1) != 0;
+    return decide(entry, changed, now);
+}
+
+void ChangeFilter::sent(Entry *entry, unsigned long now) {
+    entry->lastSent = now;
+    entry->hasLast = true;
+    entry->stats.sent++;
+    totals.sent++;
+}
+
+void ChangeFilter::commit(const char *asset, double value, unsigned long now) {
+    Entry *entry = find(asset);
+    if (entry == NULL) {
+        return;
+    }
+    sent(entry, now);
+    entry->last = value;
+}
+
+void ChangeFilter::commit(const char *asset, const char *value, unsigned long now) {
+    Entry *entry = find(asset);
+    if (entry == NULL) {
+        return;
+    }
+    sent(entry, now);
+    unsigned int length = strlen(value);
+    strncpy(entry->lastText, value, CHANGE_FILTER_TEXT_LENGTH - 1);
+    entry->lastText[CHANGE_FILTER_TEXT_LENGTH - 1] = '\0';
+    entry->lastTextLength = length;
+    entry->lastTextHash = length < CHANGE_FILTER_TEXT_LENGTH ? 0 : hashName(value);
+}
+
+void ChangeFilter::suppress(const char *asset) {
+    Entry *entry = find(asset);
+    if (entry == NULL) {
+        return;
+    }
+    entry->stats.suppressed++;
+    totals.suppressed++;
+}
+
+ChangeFilterStats ChangeFilter::getStats() {
+    return totals;
+}
+
+ChangeFilterStats ChangeFilter::getStats(const char *asset) {
+    Entry *entry = find(asset);
+    return entry == NULL ? ChangeFilterStats() : entry->stats;
+}
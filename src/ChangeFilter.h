@@ -0,0 +1,90 @@
+#ifndef CHANGE_FILTER_H_
+#define CHANGE_FILTER_H_
+
+#include <stdint.h>
+
+#define CHANGE_FILTER_MAX_ASSETS 16
+#define CHANGE_FILTER_NAME_LENGTH 32    // Including the terminating zero
+#define CHANGE_FILTER_TEXT_LENGTH 32    // Text kept to compare against, including the terminating zero
+
+// Sent and suppressed values of filtered assets
+class ChangeFilterStats {
+public:
+    unsigned long sent = 0;
+    unsigned long suppressed = 0;
+};
+
+// Report by exception: decides per asset whether a new value is worth
+// sending. A value is sent when it differs from the last sent value by more
+// than the absolute deadband or the relative deadband (a fraction of the
+// last sent value), whichever is larger. With both at 0 every change is sent.
+// Values are never sent sooner than minInterval after the previous one, and
+// always once heartbeat has passed without a send. Times are milliseconds
+// and 0 turns that check off. Text values are sent whenever they change:
+// the last one is kept up to CHANGE_FILTER_TEXT_LENGTH - 1 characters and
+// compared exactly. Longer text is compared by that start, its length and
+// a 32-bit hash, so a change that keeps all three is missed.
+//
+// Filters live in a fixed table looked up by name hash, so nothing is
+// allocated. Doesn't depend on the Arduino core, so it also builds on a host.
+class ChangeFilter {
+public:
+    ChangeFilter();
+
+    // False if the table is full or the name is too long. Adding an asset
+    // again changes its settings and forgets its last value.
+    bool add(const char *asset, float deadband, float relativeDeadband = 0,
+             unsigned long minInterval = 0, unsigned long heartbeat = 0);
+    bool remove(const char *asset);
+    bool contains(const char *asset);
+
+    // True if value should be sent at time now. Only looks: commit() a
+    // value once it was sent, and suppress() one that check() turned down.
+    // Assets without a filter are always sent and not counted.
+    bool check(const char *asset, double value, unsigned long now);
+    bool check(const char *asset, const char *value, unsigned long now);
+    void commit(const char *asset, double value, unsigned long now);
+    void commit(const char *asset, const char *value, unsigned long now);
+    void suppress(const char *asset);
+
+    ChangeFilterStats getStats();
+    // Zeroes for an asset without a filter
+    ChangeFilterStats getStats(const char *asset);
+
+private:
+    class Entry {
+    public:
+        char name[CHANGE_FILTER_NAME_LENGTH];
+        uint32_t hash;
+        float deadband;
+        float relativeDeadband;
+        unsigned long minInterval;
+        unsigned long heartbeat;
+        double last;
+        char lastText[CHANGE_FILTER_TEXT_LENGTH];
+        unsigned int lastTextLength;
+        uint32_t lastTextHash;
+        unsigned long lastSent;
+        bool used;
+        bool hasLast;
+        ChangeFilterStats stats;
+    };
+
+    // Open addressing with linear probing; slots hold an entry index + 1,
+    // EMPTY or REMOVED. Twice as many slots as entries keeps probes short.
+    static const unsigned int slotCount = CHANGE_FILTER_MAX_ASSETS * 2;
+    static const unsigned char EMPTY = 0;
+    static const unsigned char REMOVED = 0xFF;
+
+    Entry entries[CHANGE_FILTER_MAX_ASSETS];
+    unsigned char slots[slotCount];
+    ChangeFilterStats totals;
+
+    static uint32_t hashName(const char *name);
+    int findSlot(const char *asset, uint32_t hash);
+    Entry *find(const char *asset);
+    bool decide(Entry *entry, bool changed, unsigned long now);
+    void sent(Entry *entry, unsigned long now);
+};
+
+#endif
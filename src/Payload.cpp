@@ -0,0 +1,15 @@
+#include <Arduino.h>
+
+#include "Payload.h"
+
+unsigned int Payload::encodedSize() {
+    return getSize();
+}
+
+size_t Payload::writeTo(Print &out) {
+    unsigned int size = getSize();
+    if (size == 0) {
+        return 0;
+    }
+    return out.write(getBytes(), size);
+}
@@ -1,11 +1,21 @@
 #ifndef PAYLOAD_H_
 #define PAYLOAD_H_
 
+#include <stddef.h>
+
+class Print;
+
 class Payload {
 public:
     virtual unsigned char* getBytes() = 0;
     virtual unsigned int getSize() = 0;
     virtual void reset() = 0;
+
+    // Exact number of bytes writeTo() is going to write
+    virtual unsigned int encodedSize();
+    // Writes the payload to out, without first putting it together in one buffer
+    // where the payload type allows it. Returns the number of bytes written.
+    virtual size_t writeTo(Print &out);
 };
 
 #endif
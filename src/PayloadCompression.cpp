@@ -0,0 +1,123 @@
+#include "PayloadCompression.h"
+
+static const unsigned int WINDOW_SIZE = 1 << 8;
+static const unsigned int LOOKAHEAD_SIZE = 1 << 4;
+// A back-reference (13 bits) only pays off from two bytes (18 bits)
+static const unsigned int MINIMUM_MATCH = 2;
+
+class BitWriter {
+public:
+    BitWriter(unsigned char *out, unsigned int capacity) : out(out), capacity(capacity) {}
+
+    bool put(unsigned int value, unsigned int count) {
+        while (count > 0) {
+            if (used == 0) {
+                if (size >= capacity) {
+                    return false;
+                }
+                out[size++] = 0;
+            }
+            unsigned int take = 8 - used < count ? 8 - used : count;
+            out[size - 1] |= ((value >> (count - take)) & ((1 << take) - 1)) << (8 - used - take);
+            used = (used + take) % 8;
+            count -= take;
+        }
+        return true;
+    }
+
+    unsigned int getSize() { return size; }
+
+private:
+    unsigned char *out;
+    unsigned int capacity;
+    unsigned int size = 0;
+    unsigned int used = 0;
+};
+
+unsigned int compressPayload(const unsigned char *data, unsigned int size, unsigned char *out, unsigned int capacity) {
+    BitWriter writer(out, capacity);
+    unsigned int position = 0;
+
+    while (position < size) {
+        unsigned int limit = size - position < LOOKAHEAD_SIZE ? size - position : LOOKAHEAD_SIZE;
+        unsigned int bestLength = 0;
+        unsigned int bestDistance = 0;
+        unsigned int start = position > WINDOW_SIZE ? position - WINDOW_SIZE : 0;
+
+        // Nearest candidates first, so ties pick the cheapest to decode
+        for (unsigned int candidate = position; candidate-- > start;) {
+            if (data[candidate] != data[position] || data[candidate + bestLength] != data[position + bestLength]) {
+                continue;
+            }
+            unsigned int length = 1;
+            while (length < limit && data[candidate + length] == data[position + length]) {
+                length++;
+            }
+            if (length > bestLength) {
+                bestLength = length;
+                bestDistance = position - candidate;
+                if (length == limit) {
+                    break;
+                }
+            }
+        }
+
+        if (bestLength >= MINIMUM_MATCH) {
+            if (!writer.put(0, 1) || !writer.put(bestDistance - 1, 8) || !writer.put(bestLength - 1, 4)) {
+                return 0;
+            }
+            position += bestLength;
+        } else {
+            if (!writer.put(1, 1) || !writer.put(data[position], 8)) {
+                return 0;
+            }
+            position++;
+        }
+    }
+    return writer.getSize();
+}
+
+int decompressPayload(const unsigned char *data, unsigned int size, unsigned char *out, unsigned int capacity) {
+    unsigned long bits = (unsigned long)size * 8;
+    unsigned long position = 0;
+    unsigned int written = 0;
+
+    // Reads count bits, most significant first
+    auto get = [&](unsigned int count) {
+        unsigned int value = 0;
+        for (unsigned int i = 0; i < count; i++, position++) {
+            value = (value << 1) | ((data[position / 8] >> (7 - position % 8)) & 1);
+        }
+        return value;
+    };
+
+    while (position < bits) {
+        // The shortest item takes 9 bits, so this can only be the zero
+        // padding of the last byte; anything else was cut short
+        if (bits - position < 8) {
+            return get(bits - position) == 0 ? (int)written : -1;
+        }
+        if (get(1)) {
+            if (bits - position < 8) {
+                return -1;
+            }
+            if (written >= capacity) {
+                return -1;
+            }
+            out[written++] = get(8);
+        } else {
+            if (bits - position < 12) {
+                return -1;
+            }
+            unsigned int distance = get(8) + 1;
+            unsigned int length = get(4) + 1;
+            if (distance > written || length > capacity - written) {
+                return -1;
+            }
+            for (unsigned int i = 0; i < length; i++, written++) {
+                out[written] = out[written - distance];
+            }
+        }
+    }
+    return written;
+}
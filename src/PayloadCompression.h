@@ -0,0 +1,23 @@
+#ifndef PAYLOAD_COMPRESSION_H_
+#define PAYLOAD_COMPRESSION_H_
+
+// Doesn't depend on the Arduino core, so it also builds on a host
+#include <stdint.h>
+
+// LZSS in heatshrink's format with a 256 byte window and 16 byte lookahead
+// (heatshrink -w 8 -l 4), so compressed payloads can be checked with the
+// heatshrink tool. Each item is a 1 bit followed by a literal byte, or a
+// 0 bit followed by 8 bits of distance - 1 and 4 bits of length - 1,
+// most significant bit first. The input itself is the window, so
+// compressing needs no memory besides the output.
+
+// Compressed messages are published on the regular topic plus this suffix
+#define COMPRESSED_TOPIC_SUFFIX "/heatshrink"
+
+// Returns the compressed size, or 0 if it wouldn't fit in capacity
+unsigned int compressPayload(const unsigned char *data, unsigned int size, unsigned char *out, unsigned int capacity);
+// Returns the decompressed size, or -1 if it wouldn't fit in capacity or
+// data is corrupt or cut short
+int decompressPayload(const unsigned char *data, unsigned int size, unsigned char *out, unsigned int capacity);
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef PAYLOAD_POOL_H_
+#define PAYLOAD_POOL_H_
+
+#include "CborPayload.h"
+#include "BinaryPayload.h"
+
+#include <new>
+#include <type_traits>
+
+// A fixed number of payloads living in one static block, handed out as
+// leases that give their payload back when they go out of scope:
+//
+//   PayloadPool<CborPayload, 4, 256> pool; // 4 payloads of 256 bytes
+//
+//   void actuation(String value) {
+//     auto payload = pool.acquire();
+//     if (payload) {
+//       payload->set(sensor, value);
+//       device.send(*payload);
+//     }
+//   } // payload goes back to the pool here
+//
+// Nothing is allocated after the pool is constructed. Leases can't be
+// copied, only moved, e.g. into a queue until the payload has been sent.
+
+// Builds a payload writing into buffer; add an overload to pool other payloads
+inline void constructPayload(CborPayload *slot, unsigned char *buffer, unsigned int capacity) {
+    new (slot) CborPayload(buffer, capacity);
+}
+
+inline void constructPayload(BinaryPayload *slot, unsigned char *buffer, unsigned int capacity) {
+    new (slot) BinaryPayload(buffer, 0, capacity);
+}
+
+template<typename P> class PayloadLease;
+
+// Bookkeeping shared by pools of any size
+template<typename P> class PayloadPoolBase {
+public:
+    // Returns an invalid lease if every payload is in use
+    PayloadLease<P> acquire() {
+        for (unsigned int i = 0; i < count; i++) {
+            if (!used[i]) {
+                used[i] = true;
+                inUse++;
+                acquired++;
+                if (inUse > highWater) {
+                    highWater = inUse;
+                }
+                payloads[i].reset();
+                return PayloadLease<P>(this, i);
+            }
+        }
+        failures++;
+        return PayloadLease<P>(NULL, 0);
+    }
+
+    unsigned int getCount() { return count; }
+    unsigned int getInUse() { return inUse; }
+    unsigned int getHighWater() { return highWater; }    // Most payloads ever in use at once
+    unsigned long getAcquired() { return acquired; }
+    unsigned long getFailures() { return failures; }     // acquire() calls that found no free payload
+
+protected:
+    PayloadPoolBase(P *payloads, bool *used, unsigned int count)
+        : payloads(payloads), used(used), count(count) {}
+
+private:
+    friend class PayloadLease<P>;
+
+    P *payloads;
+    bool *used;
+    unsigned int count;
+    unsigned int inUse = 0;
+    unsigned int highWater = 0;
+    unsigned long acquired = 0;
+    unsigned long failures = 0;
+
+    void release(unsigned int index) {
+        used[index] = false;
+        inUse--;
+    }
+};
+
+template<typename P, unsigned int Count, unsigned int Capacity>
+class PayloadPool : public PayloadPoolBase<P> {
+public:
+    PayloadPool() : PayloadPoolBase<P>(reinterpret_cast<P *>(slots), used, Count) {
+        for (unsigned int i = 0; i < Count; i++) {
+            used[i] = false;
+            constructPayload(reinterpret_cast<P *>(&slots[i]), buffers[i], Capacity);
+        }
+    }
+
+    ~PayloadPool() {
+        for (unsigned int i = 0; i < Count; i++) {
+            reinterpret_cast<P *>(&slots[i])->~P();
+        }
+    }
+
+private:
+    PayloadPool(const PayloadPool &) = delete;
+    PayloadPool &operator=(const PayloadPool &) = delete;
+
+    unsigned char buffers[Count][Capacity];
+    typename std::aligned_storage<sizeof(P), alignof(P)>::type slots[Count];
+    bool used[Count];
+};
+
+template<typename P> class PayloadLease {
+public:
+    PayloadLease(PayloadLease &&other) : pool(other.pool), index(other.index) {
+        other.pool = NULL;
+    }
+
+    PayloadLease &operator=(PayloadLease &&other) {
+        if (this != &other) {
+            release();
+            pool = other.pool;
+            index = other.index;
+            other.pool = NULL;
+        }
+        return *this;
+    }
+
+    ~PayloadLease() {
+        release();
+    }
+
+    // Gives the payload back early; the lease is invalid afterwards
+    void release() {
+        if (pool != NULL) {
+            pool->release(index);
+            pool = NULL;
+        }
+    }
+
+    bool isValid() { return pool != NULL; }
+    explicit operator bool() { return pool != NULL; }
+    P *operator->() { return &pool->payloads[index]; }
+    P &operator*() { return pool->payloads[index]; }
+
+private:
+    friend class PayloadPoolBase<P>;
+    PayloadLease(PayloadPoolBase<P> *pool, unsigned int index) : pool(pool), index(index) {}
+    PayloadLease(const PayloadLease &) = delete;
+    PayloadLease &operator=(const PayloadLease &) = delete;
+
+    PayloadPoolBase<P> *pool;
+    unsigned int index;
+};
+
+#endif
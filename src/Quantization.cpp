@@ -0,0 +1,60 @@
+#include "Quantization.h"
+
+#include <math.h>
+
+Quantization::Quantization(float scale, float offset, unsigned int bits) {
+    valid = bits >= 2 && bits <= 32 && scale != 0 && isfinite(scale) && isfinite(offset);
+    // Clamped anyway, so quantize() stays defined
+    if (bits < 2) {
+        bits = 2;
+    } else if (bits > 32) {
+        bits = 32;
+    }
+    this->scale = scale;
+    this->offset = offset;
+    this->bits = bits;
+    // Multiplying is a lot cheaper than dividing without an FPU
+    inverse = 1 / scale;
+    maximum = (int32_t)((1UL << (bits - 1)) - 1);
+    minimum = -maximum - 1;
+
+    decimal = false;
+    exponent = 0;
+    offsetSteps = 0;
+    double power = 1e-9;
+    for (int e = -9; e <= 9 && valid; e++, power *= 10) {
+        if (scale != (float)power)
+            continue;
+        double steps = floor(offset / power + 0.5);
+        if (fabs(steps) < 2147483648.0 && (float)(steps * power) == offset) {
+            decimal = true;
+            exponent = e;
+            offsetSteps = (int32_t)steps;
+        }
+        break;
+    }
+}
+
+bool Quantization::isValid() const {
+    return valid;
+}
+
+bool Quantization::isDecimal() const {
+    return decimal;
+}
+
+int32_t Quantization::quantize(float value) const {
+    float scaled = (value - offset) * inverse;
+    // Also catches NaN
+    if (!(scaled > (float)minimum)) {
+        return minimum;
+    }
+    if (scaled >= (float)maximum) {
+        return maximum;
+    }
+    return (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+float Quantization::restore(int32_t value) const {
+    return offset + value * scale;
+}
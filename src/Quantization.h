@@ -0,0 +1,45 @@
+#ifndef QUANTIZATION_H_
+#define QUANTIZATION_H_
+
+#include <stdint.h>
+
+// Describes how a float asset is sent as a small integer:
+//
+//   integer = round((value - offset) / scale), clamped to a signed integer of bits bits
+//   value   = offset + integer * scale
+//
+// e.g. Quantization(0.1) for a temperature with 0.1 °C resolution, or
+// Quantization(1, 1000, 8) for pressure around 1000 hPa.
+//
+// BinaryPayload sends only the integer, so the receiving side has to apply
+// the same scale and offset. CborPayload sends the value itself: as a
+// decimal fraction (tag 4) when the scale is a power of ten and the offset
+// a multiple of it, as a float otherwise.
+class Quantization {
+public:
+    Quantization(float scale, float offset = 0, unsigned int bits = 16);
+
+    // False for fewer than 2 or more than 32 bits, or a scale of 0;
+    // payloads refuse to add values with such a quantization
+    bool isValid() const;
+    int32_t quantize(float value) const;
+    float restore(int32_t value) const;
+    // True if scale is 10^exponent and offset is offsetSteps times scale,
+    // so offset + integer * scale is exactly (integer + offsetSteps) * 10^exponent
+    bool isDecimal() const;
+
+    float scale;
+    float offset;
+    unsigned int bits;
+    int exponent;
+    int32_t offsetSteps;
+
+private:
+    bool valid;
+    bool decimal;
+    float inverse;
+    int32_t minimum;
+    int32_t maximum;
+};
+
+#endif
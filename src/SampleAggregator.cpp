@@ -0,0 +1,135 @@
+#include "SampleAggregator.h"
+
+SampleAggregator::SampleAggregator(unsigned long window, unsigned int maxAssets, unsigned int slices) {
+    if (slices == 0) {
+        slices = 1;
+    }
+    this->maxAssets = maxAssets;
+    sliceCount = slices;
+    sliceLength = window / slices > 0 ? window / slices : 1;
+    this->slices = new Slice[maxAssets * slices];
+    names = new const char *[maxAssets];
+    for (unsigned int slice = 0; slice < sliceCount; slice++) {
+        clearSlice(slice);
+    }
+}
+
+SampleAggregator::~SampleAggregator() {
+    delete[] slices;
+    delete[] names;
+}
+
+void SampleAggregator::clearSlice(unsigned int slice) {
+    for (unsigned int asset = 0; asset < maxAssets; asset++) {
+        Slice &s = slices[asset * sliceCount + slice];
+        s.count = 0;
+        s.sum = 0;
+        s.sumSquares = 0;
+    }
+}
+
+int SampleAggregator::addAsset(const char *name) {
+    if (assetCount == maxAssets) {
+        return -1;
+    }
+    names[assetCount] = name;
+    return assetCount++;
+}
+
+void SampleAggregator::add(unsigned int asset, float value) {
+    Slice &s = slices[asset * sliceCount + current];
+    if (s.count == 0) {
+        s.min = value;
+        s.max = value;
+        s.shift = value;
+    } else if (value < s.min) {
+        s.min = value;
+    } else if (value > s.max) {
+        s.max = value;
+    }
+    double delta = value - s.shift;
+    s.sum += delta;
+    s.sumSquares += delta * delta;
+    s.count++;
+}
+
+bool SampleAggregator::isComplete(unsigned long now) {
+    if (!started) {
+        started = true;
+        sliceStart = now;
+    }
+    return now - sliceStart >= sliceLength;
+}
+
+// Slices are merged pairwise (Chan et al.) from their count, mean and
+// sum of squared deviations
+SampleStats SampleAggregator::getStats(unsigned int asset) {
+    SampleStats stats;
+    double squares = 0;
+    for (unsigned int slice = 0; slice < sliceCount; slice++) {
+        Slice &s = slices[asset * sliceCount + slice];
+        if (s.count == 0) {
+            continue;
+        }
+        double mean = s.shift + s.sum / s.count;
+        double sliceSquares = s.sumSquares - s.sum * s.sum / s.count;
+        if (sliceSquares < 0) {
+            sliceSquares = 0;
+        }
+
+        if (stats.count == 0) {
+            stats.min = s.min;
+            stats.max = s.max;
+            stats.mean = mean;
+            squares = sliceSquares;
+        } else {
+            if (s.min < stats.min) stats.min = s.min;
+            if (s.max > stats.max) stats.max = s.max;
+            double total = (double)stats.count + s.count;
+            double delta = mean - stats.mean;
+            stats.mean += delta * s.count / total;
+            squares += sliceSquares + delta * delta * stats.count * s.count / total;
+        }
+        stats.count += s.count;
+    }
+    stats.variance = stats.count > 1 ? squares / (stats.count - 1) : 0;
+    return stats;
+}
+
+bool SampleAggregator::emit(CborPayload &payload, unsigned long now) {
+    bool emitted = false;
+    bool complete = true;
+    for (unsigned int asset = 0; asset < assetCount; asset++) {
+        SampleStats stats = getStats(asset);
+        if (stats.count == 0) {
+            continue;
+        }
+        CborBuilder object = payload.setObject((char *)names[asset], 5);
+        object.set((char *)"count", stats.count);
+        object.set((char *)"min", stats.min);
+        object.set((char *)"max", stats.max);
+        object.set((char *)"mean", (float)stats.mean);
+        object.set((char *)"variance", (float)stats.variance);
+        if (object.end()) {
+            emitted = true;
+        } else {
+            complete = false;
+        }
+    }
+
+    // Windows stay aligned to their start; slices that were missed because
+    // emit() came late are cleared as well
+    unsigned long steps = 1;
+    if (started && now - sliceStart >= sliceLength) {
+        steps = (now - sliceStart) / sliceLength;
+        sliceStart += steps * sliceLength;
+    } else {
+        sliceStart = started ? sliceStart + sliceLength : now;
+    }
+    started = true;
+    for (unsigned long step = 0; step < steps && step < sliceCount; step++) {
+        current = (current + 1) % sliceCount;
+        clearSlice(current);
+    }
+    return emitted && complete;
+}
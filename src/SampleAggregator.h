@@ -0,0 +1,79 @@
+#ifndef SAMPLE_AGGREGATOR_H_
+#define SAMPLE_AGGREGATOR_H_
+
+#include "CborPayload.h"
+
+#include <stdint.h>
+
+// Count, minimum, maximum, mean and sample variance of one asset over a window
+class SampleStats {
+public:
+    unsigned long count = 0;
+    float min = 0;
+    float max = 0;
+    double mean = 0;
+    double variance = 0;
+};
+
+// Reduces fast sampled assets to per-window statistics, so only those are
+// published instead of every sample:
+//
+//   SampleAggregator aggregator(1000);        // 1 second tumbling windows
+//   int vibration = aggregator.addAsset("vibration");
+//
+//   aggregator.add(vibration, analogRead(A0)); // for every sample
+//   if (aggregator.isComplete(millis())) {
+//       aggregator.emit(payload, millis());   // {count, min, max, mean, variance} per asset
+//       device.send(payload);
+//   }
+//
+// With slices > 1 windows slide: they're emitted every window / slices
+// milliseconds and cover the last slices of them. Memory only grows with
+// assets and slices, never with the number of samples. Asset names aren't
+// copied, so they have to outlive the aggregator.
+class SampleAggregator {
+public:
+    SampleAggregator(unsigned long window, unsigned int maxAssets = 4, unsigned int slices = 1);
+    ~SampleAggregator();
+
+    // Returns the index to add samples with, or -1 if maxAssets are already added
+    int addAsset(const char *name);
+    // Takes no time and doesn't check asset, so it can be called for every sample
+    void add(unsigned int asset, float value);
+
+    // True once the current window (or slice of it) has ended at time now
+    bool isComplete(unsigned long now);
+    // Statistics of the current window so far, all zero without samples
+    SampleStats getStats(unsigned int asset);
+    // Sets the statistics of each asset with samples as an object on payload
+    // and starts the next window. False if no asset had any samples, or if
+    // an asset didn't fit on payload; that one is left out.
+    bool emit(CborPayload &payload, unsigned long now);
+
+private:
+    // Sums are taken relative to the first sample, which keeps the variance
+    // accurate without a division per sample
+    class Slice {
+    public:
+        unsigned long count;
+        float min;
+        float max;
+        float shift;
+        double sum;
+        double sumSquares;
+    };
+
+    Slice *slices;
+    const char **names;
+    unsigned int assetCount = 0;
+    unsigned int maxAssets;
+    unsigned int sliceCount;
+    unsigned int current = 0;
+    unsigned long sliceLength;
+    unsigned long sliceStart = 0;
+    bool started = false;
+
+    void clearSlice(unsigned int slice);
+};
+
+#endif